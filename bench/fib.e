@@ -0,0 +1,12 @@
+# recursive calls
+# ops: 242785
+
+function fib(n::Integer)
+  if n < 2
+    n
+  else
+    fib(n - 1) + fib(n - 2)
+  end
+end
+
+println(fib(25))
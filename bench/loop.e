@@ -0,0 +1,11 @@
+# tight loop over scalars
+# ops: 1000000
+
+total = 0
+i = 0
+while i < 1000000
+  i = i + 1
+  total = total + i
+end
+
+println(total)
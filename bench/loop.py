@@ -0,0 +1,7 @@
+total = 0
+i = 0
+while i < 1000000:
+    i = i + 1
+    total = total + i
+
+print(total)
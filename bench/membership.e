@@ -0,0 +1,12 @@
+# `in` over a vector
+# ops: 100000
+
+v = range(1000)
+hits = 0
+for i in 1:100000
+  if i in v
+    hits = hits + 1
+  end
+end
+
+println(hits)
@@ -0,0 +1,7 @@
+v = list(range(1, 1001))
+hits = 0
+for i in range(1, 100001):
+    if i in v:
+        hits = hits + 1
+
+print(hits)
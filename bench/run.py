@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""Runs the bench/ workloads and writes the timings as JSON.
+
+Every `name.e` here is a workload. Its `# ops: N` header line gives the
+number of operations it performs, used to report ops/sec. When --python is
+given, the `name.py` twin is timed under CPython as well and both outputs
+are compared. Each run is preceded by an untimed warm-up, which also fills
+the compiled program cache.
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def measure(command):
+    """Wall time, peak RSS and stdout of one run."""
+    with tempfile.TemporaryFile() as out, tempfile.TemporaryFile() as err:
+        start = time.perf_counter()
+        process = subprocess.Popen(command, stdout=out, stderr=err)
+        _, status, usage = os.wait4(process.pid, 0)
+        elapsed = time.perf_counter() - start
+        process.returncode = os.waitstatus_to_exitcode(status)
+
+        out.seek(0)
+        err.seek(0)
+        if process.returncode != 0:
+            sys.exit("%s failed (%d):\n%s" % (" ".join(command), process.returncode, err.read().decode()))
+
+        # ru_maxrss is in KiB on Linux
+        return elapsed, usage.ru_maxrss, out.read().decode()
+
+
+def trials(command, count, ops):
+    measure(command)
+    runs = [measure(command) for _ in range(count)]
+    times = [run[0] for run in runs]
+    median = statistics.median(times)
+
+    return {
+        "command": command,
+        "times": times,
+        "best": min(times),
+        "median": median,
+        "ops_per_sec": ops / median if median > 0 else None,
+        "max_rss_kb": max(run[1] for run in runs),
+    }, runs[-1][2]
+
+
+def result_line(output):
+    # the last line a workload prints, after elc's banner
+    lines = [line for line in output.splitlines() if line.strip()]
+    return lines[-1] if lines else ""
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("names", nargs="*", help="workloads to run (default: all)")
+    parser.add_argument("--elc", default=os.path.join(HERE, "..", "out", "release", "elc"))
+    parser.add_argument("--python", help="also time the .py twins with this interpreter")
+    parser.add_argument("--trials", type=int, default=5)
+    parser.add_argument("--output", help="JSON file to write (default: stdout only)")
+    args = parser.parse_args()
+
+    names = args.names or sorted(name[:-2] for name in os.listdir(HERE) if name.endswith(".e"))
+    report = {
+        "timestamp": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+        "host": {"machine": platform.machine(), "system": platform.system(), "cpus": os.cpu_count()},
+        "elc": os.path.abspath(args.elc),
+        "version": None,
+        "trials": args.trials,
+        "benchmarks": [],
+    }
+
+    for name in names:
+        script = os.path.join(HERE, name + ".e")
+        with open(script) as source:
+            match = re.search(r"^# ops: (\d+)$", source.read(), re.MULTILINE)
+        ops = int(match.group(1)) if match else 1
+
+        entry = {"name": name, "ops": ops}
+        entry["elc"], elc_output = trials([args.elc, script], args.trials, ops)
+        banner = re.search(r"E Language Compiler v(\S+)", elc_output)
+        report["version"] = report["version"] or (banner.group(1) if banner else None)
+        line = "%-12s elc %8.3fs %12.0f ops/s %8d KiB" % (name, entry["elc"]["median"], entry["elc"]["ops_per_sec"], entry["elc"]["max_rss_kb"])
+
+        twin = os.path.join(HERE, name + ".py")
+        if args.python and os.path.exists(twin):
+            entry["python"], python_output = trials([args.python, twin], args.trials, ops)
+            entry["speedup"] = entry["python"]["median"] / entry["elc"]["median"]
+            entry["outputs_match"] = result_line(elc_output) == result_line(python_output)
+            line += "   python %8.3fs  x%.2f%s" % (entry["python"]["median"], entry["speedup"],
+                                                  "" if entry["outputs_match"] else "  OUTPUT MISMATCH")
+
+        report["benchmarks"].append(entry)
+        print(line, flush=True)
+
+    if args.output:
+        with open(args.output, "w") as out:
+            json.dump(report, out, indent=2)
+            out.write("\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,14 @@
+# string concatenation and split
+# ops: 20000
+
+s = 'ab,'
+for i in 1:9999
+  s = s + 'ab,'
+end
+
+n = 0
+for part in split(s, ',')
+  n = n + length(part)
+end
+
+println(n)
@@ -0,0 +1,9 @@
+s = 'ab,'
+for i in range(1, 10000):
+    s = s + 'ab,'
+
+n = 0
+for part in s.split(','):
+    n = n + len(part)
+
+print(n)
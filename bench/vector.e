@@ -0,0 +1,14 @@
+# vector push and index
+# ops: 400000
+
+v = zeros(0)
+for i in 1:200000
+  push!(v, i)
+end
+
+total = 0
+for i in 1:200000
+  total = total + v[i]
+end
+
+println(total)
@@ -0,0 +1,9 @@
+v = []
+for i in range(1, 200001):
+    v.append(i)
+
+total = 0
+for i in range(1, 200001):
+    total = total + v[i - 1]
+
+print(total)
@@ -0,0 +1,392 @@
+#include "archive.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+using namespace ELang::Runtime;
+
+namespace {
+
+constexpr char magic[] = { 'E', 'L', 'C', 'V' };
+constexpr std::uint8_t format = 1;
+
+enum Tag: std::uint8_t {
+    TagVoid = 1,
+    TagInteger,
+    TagFloat,
+    TagBoolean,
+    TagString,
+    TagVector,
+    TagIntegers,
+    TagFloats,
+    TagMatrix,
+    TagMask,
+    TagReference,
+};
+
+class Writer {
+public:
+    explicit Writer(std::string& out): out(out) { }
+
+    std::string error;
+
+    bool value(const Value& value) {
+        switch (value.type) {
+            case Type::Void:
+                byte(TagVoid);
+                return true;
+            case Type::Integer:
+                byte(TagInteger);
+                integer(std::get<long>(value.value));
+                return true;
+            case Type::Float:
+                byte(TagFloat);
+                raw(&std::get<double>(value.value), sizeof(double));
+                return true;
+            case Type::Boolean:
+                byte(TagBoolean);
+                byte(std::get<bool>(value.value));
+                return true;
+            case Type::String: {
+                const auto str = std::get<std::shared_ptr<StringSlice>>(value.value);
+                if (!first_visit(str.get())) {
+                    return true;
+                }
+
+                byte(TagString);
+                varint(str->length);
+                out.append(str->view());
+                return true;
+            }
+            case Type::Vector:
+                return vector(*std::get<std::shared_ptr<VectorSlice>>(value.value));
+            case Type::Matrix: {
+                const auto mat = std::get<std::shared_ptr<Matrix>>(value.value);
+                if (!first_visit(mat.get())) {
+                    return true;
+                }
+
+                byte(TagMatrix);
+                varint(mat->rows);
+                varint(mat->cols);
+                block(mat->data.data(), mat->data.size() * sizeof(double));
+                return true;
+            }
+            case Type::Mask: {
+                const auto mask = std::get<std::shared_ptr<Mask>>(value.value);
+                if (!first_visit(mask.get())) {
+                    return true;
+                }
+
+                byte(TagMask);
+                varint(mask->length);
+                block(mask->words.data(), mask->words.size() * sizeof(std::uint64_t));
+                return true;
+            }
+            case Type::Function:
+                error = "Function";
+                return false;
+            case Type::Task:
+                error = "Task";
+                return false;
+            case Type::Generator:
+                error = "Generator";
+                return false;
+            case Type::File:
+                error = "File";
+                return false;
+            default:
+                error = "Any";
+                return false;
+        }
+    }
+
+private:
+    std::string& out;
+
+    // objects already written, by address, numbered in the order they were met
+    std::map<const void*, std::size_t> seen;
+
+    void byte(const std::uint8_t value) {
+        out.push_back(static_cast<char>(value));
+    }
+
+    void varint(std::uint64_t value) {
+        while (value >= 0x80) {
+            byte(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        byte(static_cast<std::uint8_t>(value));
+    }
+
+    void integer(const long value) {
+        varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    void raw(const void* data, const std::size_t length) {
+        out.append(static_cast<const char*>(data), length);
+    }
+
+    // padded so the block starts 8-byte aligned in the file (and the mapping)
+    void block(const void* data, const std::size_t length) {
+        out.append((8 - out.size() % 8) % 8, '\0');
+        raw(data, length);
+    }
+
+    // false (after writing the back reference) when `object` was written before
+    bool first_visit(const void* object) {
+        const auto it = seen.find(object);
+        if (it != seen.end()) {
+            byte(TagReference);
+            varint(it->second);
+            return false;
+        }
+
+        seen.emplace(object, seen.size());
+        return true;
+    }
+
+    bool vector(const VectorSlice& vec) {
+        if (!first_visit(&vec)) {
+            return true;
+        }
+
+        const auto homogeneous = [&vec](const Type type) {
+            return vec.length > 0 && std::all_of(vec.begin(), vec.end(), [type](const Value& el) { return el.type == type; });
+        };
+
+        if (homogeneous(Type::Integer)) {
+            byte(TagIntegers);
+            varint(vec.length);
+            out.append((8 - out.size() % 8) % 8, '\0');
+            for (const auto& el: vec) {
+                raw(&std::get<long>(el.value), sizeof(long));
+            }
+            return true;
+        }
+
+        if (homogeneous(Type::Float)) {
+            byte(TagFloats);
+            varint(vec.length);
+            out.append((8 - out.size() % 8) % 8, '\0');
+            for (const auto& el: vec) {
+                raw(&std::get<double>(el.value), sizeof(double));
+            }
+            return true;
+        }
+
+        byte(TagVector);
+        varint(vec.length);
+        for (const auto& el: vec) {
+            if (!value(el)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+class Reader {
+public:
+    explicit Reader(const std::shared_ptr<const MappedFile>& file):
+        file(file), whole(std::make_shared<StringSlice>(file)), cursor(file->data), end(file->data + file->size) { }
+
+    bool header() {
+        if (static_cast<std::size_t>(end - cursor) < sizeof(magic) + 1 || std::memcmp(cursor, magic, sizeof(magic)) != 0) {
+            return false;
+        }
+
+        cursor += sizeof(magic);
+        return byte() == format;
+    }
+
+    Value value() {
+        switch (byte()) {
+            case TagVoid:
+                return Value();
+            case TagInteger:
+                return Value(integer());
+            case TagFloat: {
+                auto result = 0.0;
+                std::memcpy(&result, take(sizeof(double)), sizeof(double));
+                return Value(result);
+            }
+            case TagBoolean:
+                return Value(byte() != 0);
+            case TagString: {
+                const auto length = varint();
+                const auto data = take(length);
+                return remember(Value(std::make_shared<StringSlice>(*whole, data - file->data, length)));
+            }
+            case TagVector: {
+                const auto length = count(1);
+                const auto storage = std::make_shared<std::vector<Value>>();
+                const auto result = remember(Value(std::make_shared<VectorSlice>(storage)));
+
+                // registered before the elements, which may refer back to it
+                storage->reserve(length);
+                for (std::uint64_t i = 0; i < length; ++i) {
+                    storage->push_back(value());
+                }
+
+                // the slice was made over empty storage, charge what it holds now
+                const auto slice = std::get<std::shared_ptr<VectorSlice>>(result.value);
+                slice->length = length;
+                slice->charge.resize(storage->capacity() * sizeof(Value));
+                return result;
+            }
+            case TagIntegers:
+                return remember(Value(numbers<long>()));
+            case TagFloats:
+                return remember(Value(numbers<double>()));
+            case TagMatrix: {
+                const auto rows = varint();
+                const auto cols = varint();
+                if (cols != 0 && rows > static_cast<std::uint64_t>(end - cursor) / sizeof(double) / cols) {
+                    throw std::out_of_range("load");
+                }
+
+                const auto result = std::make_shared<Matrix>(rows, cols);
+                std::memcpy(result->data.data(), aligned(rows * cols * sizeof(double)), rows * cols * sizeof(double));
+                return remember(Value(result));
+            }
+            case TagMask: {
+                const auto length = varint();
+                const auto words = length / 64 + (length % 64 != 0);
+                if (words > static_cast<std::uint64_t>(end - cursor) / sizeof(std::uint64_t)) {
+                    throw std::out_of_range("load");
+                }
+
+                const auto result = std::make_shared<Mask>(length);
+                std::memcpy(result->words.data(), aligned(words * sizeof(std::uint64_t)), words * sizeof(std::uint64_t));
+                result->trim();
+                return remember(Value(result));
+            }
+            case TagReference: {
+                const auto index = varint();
+                if (index >= objects.size()) {
+                    throw std::out_of_range("load");
+                }
+
+                return objects[index];
+            }
+            default:
+                throw std::out_of_range("load");
+        }
+    }
+
+    inline bool done() const { return cursor == end; }
+
+private:
+    std::shared_ptr<const MappedFile> file;
+    std::shared_ptr<StringSlice> whole;
+    const char* cursor;
+    const char* end;
+
+    // in the writer's numbering, for back references
+    std::vector<Value> objects;
+
+    std::uint8_t byte() {
+        return static_cast<std::uint8_t>(*take(1));
+    }
+
+    std::uint64_t varint() {
+        auto value = std::uint64_t(0);
+
+        for (auto shift = 0; shift < 64; shift += 7) {
+            const auto b = byte();
+            value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+
+        throw std::out_of_range("load");
+    }
+
+    long integer() {
+        const auto value = varint();
+        return static_cast<long>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    const char* take(const std::uint64_t length) {
+        if (length > static_cast<std::uint64_t>(end - cursor)) {
+            throw std::out_of_range("load");
+        }
+
+        const auto data = cursor;
+        cursor += length;
+        return data;
+    }
+
+    const char* aligned(const std::uint64_t length) {
+        take((8 - (cursor - file->data) % 8) % 8);
+        return take(length);
+    }
+
+    // an element count, bounded by the bytes left at `size` bytes each
+    std::uint64_t count(const std::size_t size) {
+        const auto length = varint();
+        if (length > static_cast<std::uint64_t>(end - cursor) / size) {
+            throw std::out_of_range("load");
+        }
+
+        return length;
+    }
+
+    template<typename Number>
+    std::shared_ptr<std::vector<Value>> numbers() {
+        const auto length = count(sizeof(Number));
+        const auto data = aligned(length * sizeof(Number));
+        const auto result = std::make_shared<std::vector<Value>>();
+
+        result->reserve(length);
+        for (std::uint64_t i = 0; i < length; ++i) {
+            auto number = Number();
+            std::memcpy(&number, data + i * sizeof(Number), sizeof(Number));
+            result->push_back(Value(number));
+        }
+
+        return result;
+    }
+
+    Value remember(const Value& value) {
+        objects.push_back(value);
+        return value;
+    }
+};
+
+} // namespace
+
+bool ELang::Runtime::save_value(const Value& value, std::string& out, std::string& error) {
+    Writer writer(out);
+
+    out.append(magic, sizeof(magic));
+    out.push_back(static_cast<char>(format));
+
+    if (!writer.value(value)) {
+        error = writer.error;
+        return false;
+    }
+
+    return true;
+}
+
+bool ELang::Runtime::load_value(const std::shared_ptr<const MappedFile>& file, Value& value) {
+    try {
+        Reader reader(file);
+        if (!reader.header()) {
+            return false;
+        }
+
+        value = reader.value();
+        return reader.done();
+    }
+    catch (const std::out_of_range&) {
+        return false;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "vm.hpp"
+#include "mapped.hpp"
+#include <memory>
+#include <string>
+
+namespace ELang {
+namespace Runtime {
+
+// Binary form of runtime values, what `save` writes and `load` reads back.
+// Values go in pre-order behind a one byte tag with varint lengths, like the
+// program cache. Vectors of only Integers or only Floats, matrices and masks
+// are written as raw 8-byte aligned blocks. A vector, string, matrix or mask
+// reached twice is written once and referred back to, so sharing (and cycles)
+// survive the round trip.
+
+// false for values that only mean something inside a run (functions, tasks,
+// generators, files), with the type's name in `error`
+bool save_value(const Value& value, std::string& out, std::string& error);
+
+// false if `file` isn't a complete saved value. Strings in the result are
+// views of the mapping rather than copies.
+bool load_value(const std::shared_ptr<const MappedFile>& file, Value& value);
+
+} // namespace Runtime
+} // namespace ELang
@@ -1,13 +1,246 @@
 #include "builtin.hpp"
 #include "vm.hpp"
+#include "simd.hpp"
+#include "output.hpp"
+#include "file.hpp"
+#include "loader.hpp"
+#include "archive.hpp"
 
 #include <memory>
 #include <algorithm>
-#include <cctype>
 #include <string>
+#include <sstream>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <unistd.h>
+#include <functional>
+#include <chrono>
 
 using namespace ELang::Runtime;
 
+namespace {
+
+// Integer or Float as a double, false for anything else
+bool numeric_value(const Value& value, double& result) {
+    if (value.type == Type::Integer) {
+        result = static_cast<double>(std::get<long>(value.value));
+        return true;
+    }
+    else if (value.type == Type::Float) {
+        result = std::get<double>(value.value);
+        return true;
+    }
+
+    return false;
+}
+
+// zeros(r, c) / ones(r, c)
+Value make_matrix(const std::vector<Value>& params, const double fill) {
+    const auto rows = params.at(0);
+    const auto cols = params.at(1);
+
+    if (rows.type == Type::Integer && cols.type == Type::Integer
+            && std::get<long>(rows.value) >= 0 && std::get<long>(cols.value) >= 0) {
+        return Value(std::make_shared<Matrix>(std::get<long>(rows.value), std::get<long>(cols.value), fill));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+// elementwise `vec op scalar`, packed into a Mask
+template<typename Compare>
+Value compare_elements(const Value& vec, const Value& scalar, Compare compare) {
+    const auto vecval = std::get<std::shared_ptr<VectorSlice>>(vec.value);
+    const auto result = std::make_shared<Mask>(vecval->length);
+    auto rhs = 0.0;
+
+    numeric_value(scalar, rhs);
+
+    for (std::size_t i = 0; i < vecval->length; ++i) {
+        const auto& el = vecval->at(i);
+        auto lhs = 0.0;
+
+        if (el.type == Type::Integer && scalar.type == Type::Integer) {
+            if (compare(std::get<long>(el.value), std::get<long>(scalar.value))) {
+                result->set(i);
+            }
+        }
+        else if (numeric_value(el, lhs)) {
+            if (compare(lhs, rhs)) {
+                result->set(i);
+            }
+        }
+        else {
+            std::cerr << "Invalid parameter types" << std::endl;
+            throw -1;
+        }
+    }
+
+    return Value(result);
+}
+
+std::shared_ptr<Mask> combine_masks(const Value& lhs, const Value& rhs, void (*kernel)(const std::uint64_t*, const std::uint64_t*, std::uint64_t*, const std::size_t)) {
+    const auto lhsval = std::get<std::shared_ptr<Mask>>(lhs.value);
+    const auto rhsval = std::get<std::shared_ptr<Mask>>(rhs.value);
+
+    if (lhsval->length != rhsval->length) {
+        std::cerr << "Mask lengths do not match" << std::endl;
+        throw -1;
+    }
+
+    const auto result = std::make_shared<Mask>(lhsval->length);
+    kernel(lhsval->words.data(), rhsval->words.data(), result->words.data(), result->words.size());
+    return result;
+}
+
+std::shared_ptr<std::vector<Value>> float_vector(const std::vector<double>& values) {
+    const auto vec = std::make_shared<std::vector<Value>>();
+    vec->reserve(values.size());
+
+    for (const auto value: values) {
+        vec->push_back(Value(value));
+    }
+
+    return vec;
+}
+
+// shortest round-trip text of a number, with floats always showing a
+// fraction or exponent so 1.0 doesn't read as an Integer
+void append_number(std::string& out, const long number) {
+    char buffer[24];
+    const auto end = std::to_chars(buffer, buffer + sizeof(buffer), number).ptr;
+    out.append(buffer, end);
+}
+
+void append_number(std::string& out, const double number) {
+    char buffer[32];
+    const auto end = std::to_chars(buffer, buffer + sizeof(buffer), number).ptr;
+    out.append(buffer, end);
+
+    if (std::all_of(buffer, end, [](const char c) { return c == '-' || (c >= '0' && c <= '9'); })) {
+        out.append(".0");
+    }
+}
+
+// print/println formatting: plain values, no type annotations. Strings are
+// quoted only inside vectors.
+void append_value(std::string& out, const Value& value, const bool nested) {
+    switch (value.type) {
+        case Type::Integer:
+            append_number(out, std::get<long>(value.value));
+            break;
+        case Type::Float:
+            append_number(out, std::get<double>(value.value));
+            break;
+        case Type::Boolean:
+            out.append(std::get<bool>(value.value) ? "true" : "false");
+            break;
+        case Type::String:
+            if (nested) {
+                out.push_back('\'');
+            }
+            out.append(std::get<std::shared_ptr<StringSlice>>(value.value)->view());
+            if (nested) {
+                out.push_back('\'');
+            }
+            break;
+        case Type::Function:
+            out.append(std::get<std::shared_ptr<FunctionRef>>(value.value)->name);
+            break;
+        case Type::Generator:
+            out.append(std::get<std::shared_ptr<Generator>>(value.value)->name);
+            break;
+        case Type::Task:
+            out.append(std::get<std::shared_ptr<Task>>(value.value)->finished ? "finished" : "pending");
+            break;
+        case Type::File:
+            out.append(std::get<std::shared_ptr<File>>(value.value)->path);
+            break;
+        case Type::Vector: {
+            const auto vec = std::get<std::shared_ptr<VectorSlice>>(value.value);
+            out.push_back('[');
+            for (std::size_t i = 0; i < vec->length; ++i) {
+                if (i > 0) {
+                    out.append(", ");
+                }
+                append_value(out, vec->at(i), true);
+            }
+            out.push_back(']');
+            break;
+        }
+        case Type::Matrix: {
+            const auto mat = std::get<std::shared_ptr<Matrix>>(value.value);
+            out.push_back('[');
+            for (std::size_t i = 0; i < mat->rows; ++i) {
+                for (std::size_t j = 0; j < mat->cols; ++j) {
+                    if (j > 0) {
+                        out.push_back(' ');
+                    }
+                    append_number(out, mat->at(i, j));
+                }
+                if (i + 1 < mat->rows) {
+                    out.append("; ");
+                }
+            }
+            out.push_back(']');
+            break;
+        }
+        case Type::Mask: {
+            const auto mask = std::get<std::shared_ptr<Mask>>(value.value);
+            for (std::size_t i = 0; i < mask->length; ++i) {
+                out.push_back(mask->get(i) ? '1' : '0');
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+[[noreturn]] void file_error(const std::string& path) {
+    std::cerr << "Error: " << path << ": " << (errno != 0 ? std::strerror(errno) : "not open for that") << std::endl;
+    throw -1;
+}
+
+std::shared_ptr<File> open_file(const std::string& path, const File::Mode mode) {
+    const auto file = File::open(path, mode);
+    if (nullptr == file) {
+        file_error(path);
+    }
+
+    return file;
+}
+
+// the text behind read/readlines: a File opened for reading, or a path
+std::shared_ptr<StringSlice> file_text(const Value& source) {
+    if (source.type == Type::String) {
+        return open_file(std::string(std::get<std::shared_ptr<StringSlice>>(source.value)->view()), File::Mode::Read)->text();
+    }
+
+    const auto file = std::get<std::shared_ptr<File>>(source.value);
+    const auto text = file->text();
+    if (nullptr == text) {
+        errno = 0;
+        file_error(file->path);
+    }
+
+    return text;
+}
+
+[[noreturn]] void load_error(const Value& source, const LoadError& error) {
+    const auto path = source.type == Type::File ? std::get<std::shared_ptr<File>>(source.value)->path
+                                                : std::string(std::get<std::shared_ptr<StringSlice>>(source.value)->view());
+
+    std::cerr << "Error: " << path << ":" << error.line << ": " << error.message << std::endl;
+    throw -1;
+}
+
+} // namespace
+
 Value ELang::Runtime::builtin_add(const std::vector<Value>& params) {
     if (params.size() != 2) {
         std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
@@ -30,8 +263,13 @@ Value ELang::Runtime::builtin_add(const std::vector<Value>& params) {
         return Value(std::get<double>(lhs.value) + std::get<double>(rhs.value));
     }
     else if (lhs.type == Type::String && rhs.type == Type::String) {
-        return Value(std::make_shared<std::string>(*std::get<std::shared_ptr<std::string>>(lhs.value)
-             + *std::get<std::shared_ptr<std::string>>(rhs.value)));
+        const auto lhs_str = std::get<std::shared_ptr<StringSlice>>(lhs.value)->view();
+        const auto rhs_str = std::get<std::shared_ptr<StringSlice>>(rhs.value)->view();
+        const auto result = std::make_shared<std::string>();
+
+        result->reserve(lhs_str.length() + rhs_str.length());
+        result->append(lhs_str).append(rhs_str);
+        return Value(result);
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -131,6 +369,14 @@ Value ELang::Runtime::builtin_not(const std::vector<Value>& params) {
     if (expr.type == Type::Boolean) {
         return Value(!std::get<bool>(expr.value));
     }
+    else if (expr.type == Type::Mask) {
+        const auto exprval = std::get<std::shared_ptr<Mask>>(expr.value);
+        const auto result = std::make_shared<Mask>(exprval->length);
+
+        Simd::mask_not(exprval->words.data(), result->words.data(), result->words.size());
+        result->trim();
+        return Value(result);
+    }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
         throw -1;
@@ -149,6 +395,9 @@ Value ELang::Runtime::builtin_and(const std::vector<Value>& params) {
     if (lhs.type == Type::Boolean && rhs.type == Type::Boolean) {
         return Value(std::get<bool>(lhs.value) && std::get<bool>(rhs.value));
     }
+    else if (lhs.type == Type::Mask && rhs.type == Type::Mask) {
+        return Value(combine_masks(lhs, rhs, Simd::mask_and));
+    }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
         throw -1;
@@ -167,6 +416,9 @@ Value ELang::Runtime::builtin_or(const std::vector<Value>& params) {
     if (lhs.type == Type::Boolean && rhs.type == Type::Boolean) {
         return Value(std::get<bool>(lhs.value) || std::get<bool>(rhs.value));
     }
+    else if (lhs.type == Type::Mask && rhs.type == Type::Mask) {
+        return Value(combine_masks(lhs, rhs, Simd::mask_or));
+    }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
         throw -1;
@@ -198,7 +450,10 @@ Value ELang::Runtime::builtin_eq(const std::vector<Value>& params) {
         return Value(std::get<bool>(lhs.value) == std::get<bool>(rhs.value));
     }
     else if (lhs.type == Type::String && rhs.type == Type::String) {
-        return Value(*std::get<std::shared_ptr<std::string>>(lhs.value) == *std::get<std::shared_ptr<std::string>>(rhs.value));
+        return Value(std::get<std::shared_ptr<StringSlice>>(lhs.value)->view() == std::get<std::shared_ptr<StringSlice>>(rhs.value)->view());
+    }
+    else if (lhs.type == Type::Vector && (rhs.type == Type::Integer || rhs.type == Type::Float)) {
+        return compare_elements(lhs, rhs, std::equal_to<>());
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -231,7 +486,10 @@ Value ELang::Runtime::builtin_ne(const std::vector<Value>& params) {
         return Value(std::get<bool>(lhs.value) != std::get<bool>(rhs.value));
     }
     else if (lhs.type == Type::String && rhs.type == Type::String) {
-        return Value(*std::get<std::shared_ptr<std::string>>(lhs.value) != *std::get<std::shared_ptr<std::string>>(rhs.value));
+        return Value(std::get<std::shared_ptr<StringSlice>>(lhs.value)->view() != std::get<std::shared_ptr<StringSlice>>(rhs.value)->view());
+    }
+    else if (lhs.type == Type::Vector && (rhs.type == Type::Integer || rhs.type == Type::Float)) {
+        return compare_elements(lhs, rhs, std::not_equal_to<>());
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -263,6 +521,9 @@ Value ELang::Runtime::builtin_gte(const std::vector<Value>& params) {
     else if (lhs.type == Type::Boolean && rhs.type == Type::Boolean) {
         return Value(std::get<bool>(lhs.value) >= std::get<bool>(rhs.value));
     }
+    else if (lhs.type == Type::Vector && (rhs.type == Type::Integer || rhs.type == Type::Float)) {
+        return compare_elements(lhs, rhs, std::greater_equal<>());
+    }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
         throw -1;
@@ -293,6 +554,9 @@ Value ELang::Runtime::builtin_gt(const std::vector<Value>& params) {
     else if (lhs.type == Type::Boolean && rhs.type == Type::Boolean) {
         return Value(std::get<bool>(lhs.value) > std::get<bool>(rhs.value));
     }
+    else if (lhs.type == Type::Vector && (rhs.type == Type::Integer || rhs.type == Type::Float)) {
+        return compare_elements(lhs, rhs, std::greater<>());
+    }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
         throw -1;
@@ -323,6 +587,9 @@ Value ELang::Runtime::builtin_lte(const std::vector<Value>& params) {
     else if (lhs.type == Type::Boolean && rhs.type == Type::Boolean) {
         return Value(std::get<bool>(lhs.value) <= std::get<bool>(rhs.value));
     }
+    else if (lhs.type == Type::Vector && (rhs.type == Type::Integer || rhs.type == Type::Float)) {
+        return compare_elements(lhs, rhs, std::less_equal<>());
+    }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
         throw -1;
@@ -353,6 +620,9 @@ Value ELang::Runtime::builtin_lt(const std::vector<Value>& params) {
     else if (lhs.type == Type::Boolean && rhs.type == Type::Boolean) {
         return Value(std::get<bool>(lhs.value) < std::get<bool>(rhs.value));
     }
+    else if (lhs.type == Type::Vector && (rhs.type == Type::Integer || rhs.type == Type::Float)) {
+        return compare_elements(lhs, rhs, std::less<>());
+    }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
         throw -1;
@@ -360,8 +630,11 @@ Value ELang::Runtime::builtin_lt(const std::vector<Value>& params) {
 }
 
 Value ELang::Runtime::builtin_zeros(const std::vector<Value>& params) {
-    if (params.size() != 1) {
-        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+    if (params.size() == 2) {
+        return make_matrix(params, 0.0);
+    }
+    else if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1 or 2" << std::endl;
         throw -1;
     }
 
@@ -383,8 +656,11 @@ Value ELang::Runtime::builtin_zeros(const std::vector<Value>& params) {
 }
 
 Value ELang::Runtime::builtin_ones(const std::vector<Value>& params) {
-    if (params.size() != 1) {
-        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+    if (params.size() == 2) {
+        return make_matrix(params, 1.0);
+    }
+    else if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1 or 2" << std::endl;
         throw -1;
     }
 
@@ -414,12 +690,15 @@ Value ELang::Runtime::builtin_length(const std::vector<Value>& params) {
     const auto vec = params.at(0);
 
     if (vec.type == Type::Vector) {
-        const auto vecval = std::get<std::shared_ptr<std::vector<Value>>>(vec.value);
-        return Value(static_cast<long>(vecval->size()));
+        const auto vecval = std::get<std::shared_ptr<VectorSlice>>(vec.value);
+        return Value(static_cast<long>(vecval->length));
     }
     else if (vec.type == Type::String) {
-        const auto strval = std::get<std::shared_ptr<std::string>>(vec.value);
-        return Value(static_cast<long>(strval->length()));
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(vec.value);
+        return Value(static_cast<long>(strval->length));
+    }
+    else if (vec.type == Type::Mask) {
+        return Value(static_cast<long>(std::get<std::shared_ptr<Mask>>(vec.value)->length));
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -474,20 +753,15 @@ Value ELang::Runtime::builtin_push_bang(const std::vector<Value>& params) {
     const auto val = params.at(1);
 
     if (vec.type == Type::Vector) {
-        const auto vecval = std::get<std::shared_ptr<std::vector<Value>>>(vec.value);
+        const auto vecval = std::get<std::shared_ptr<VectorSlice>>(vec.value);
         
         switch(val.type) {
             case Type::Integer:
-                vecval->push_back(std::get<long>(val.value));
-                break;
             case Type::Boolean:
-                vecval->push_back(std::get<bool>(val.value));
-                break;
             case Type::Float:
-                vecval->push_back(std::get<double>(val.value));
-                break;
             case Type::Vector:
-                vecval->push_back(std::get<std::shared_ptr<std::vector<Value>>>(val.value));
+            case Type::String:
+                vecval->push_back(val);
                 break;
             default:
                 // TODO: error
@@ -511,13 +785,10 @@ Value ELang::Runtime::builtin_pop_bang(const std::vector<Value>& params) {
     const auto vec = params.at(0);
 
     if (vec.type == Type::Vector) {
-        const auto vecval = std::get<std::shared_ptr<std::vector<Value>>>(vec.value);
-        const auto last_index = vecval->size();
+        const auto vecval = std::get<std::shared_ptr<VectorSlice>>(vec.value);
 
-        if (last_index > 0) {
-            const auto grab = vecval->at(last_index - 1);
-            vecval->pop_back();
-            return Value(grab);
+        if (vecval->length > 0) {
+            return vecval->pop_back();
         }
         else {
             std::cerr << "Out of bounds." << std::endl;
@@ -531,8 +802,30 @@ Value ELang::Runtime::builtin_pop_bang(const std::vector<Value>& params) {
 }
 
 Value ELang::Runtime::builtin_at(const std::vector<Value>& params) {
-    if (params.size() != 2) {
-        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
+    if (params.size() == 3) {
+        const auto mat = params.at(0);
+        const auto row = params.at(1);
+        const auto col = params.at(2);
+
+        if (mat.type == Type::Matrix && row.type == Type::Integer && col.type == Type::Integer) {
+            const auto matval = std::get<std::shared_ptr<Matrix>>(mat.value);
+            const auto rowval = std::get<long>(row.value);
+            const auto colval = std::get<long>(col.value);
+
+            if (rowval < 1 || colval < 1 || rowval > static_cast<long>(matval->rows) || colval > static_cast<long>(matval->cols)) {
+                std::cerr << "Out of bounds." << std::endl;
+                throw -1;
+            }
+
+            return Value(matval->at(rowval - 1, colval - 1)); /* 1-based */
+        }
+        else {
+            std::cerr << "Invalid parameter types" << std::endl;
+            throw -1;
+        }
+    }
+    else if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2 or 3" << std::endl;
         throw -1;
     }
 
@@ -540,18 +833,46 @@ Value ELang::Runtime::builtin_at(const std::vector<Value>& params) {
     const auto index = params.at(1);
 
     if (vec.type == Type::Vector && index.type == Type::Integer) {
-        const auto vecval = std::get<std::shared_ptr<std::vector<Value>>>(vec.value);
+        const auto vecval = std::get<std::shared_ptr<VectorSlice>>(vec.value);
         const auto indexval = std::get<long>(index.value);
 
         //TODO: out of bounds
         return Value(vecval->at(indexval-1)); /* 1-based array */
     }
+    else if (vec.type == Type::Vector && index.type == Type::Mask) {
+        const auto vecval = std::get<std::shared_ptr<VectorSlice>>(vec.value);
+        const auto maskval = std::get<std::shared_ptr<Mask>>(index.value);
+
+        if (vecval->length != maskval->length) {
+            std::cerr << "Mask length does not match" << std::endl;
+            throw -1;
+        }
+
+        const auto result = std::make_shared<std::vector<Value>>();
+        result->reserve(Simd::popcount(maskval->words.data(), maskval->words.size()));
+
+        // jump straight to the set bits
+        for (std::size_t w = 0; w < maskval->words.size(); ++w) {
+            auto word = maskval->words[w];
+
+            while (word != 0) {
+                result->push_back(vecval->at(w * 64 + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+
+        return Value(result);
+    }
     else if (vec.type == Type::String && index.type == Type::Integer) {
-        const auto strval = std::get<std::shared_ptr<std::string>>(vec.value);
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(vec.value);
         const auto indexval = std::get<long>(index.value);
 
-        // TODO: out of bounds
-        return Value(std::make_shared<std::string>(1, strval->at(indexval-1)));
+        if (indexval < 1 || indexval > static_cast<long>(strval->length)) {
+            std::cerr << "Out of bounds." << std::endl;
+            throw -1;
+        }
+
+        return Value(std::make_shared<StringSlice>(*strval, indexval - 1, 1));
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -569,7 +890,7 @@ Value ELang::Runtime::builtin_in(const std::vector<Value>& params) {
     const auto val = params.at(1);
 
     if (vec.type == Type::Vector) {
-        const auto vecval = std::get<std::shared_ptr<std::vector<Value>>>(vec.value);
+        const auto vecval = std::get<std::shared_ptr<VectorSlice>>(vec.value);
 
         return Value(std::find_if(vecval->begin(), vecval->end(),
             [val](const ELang::Runtime::Value v) { return  v.type == val.type && v.value == val.value; }) != vecval->end());
@@ -580,91 +901,42 @@ Value ELang::Runtime::builtin_in(const std::vector<Value>& params) {
     }
 }
 
-Value ELang::Runtime::builtin_show(const std::vector<Value>& params) {
-    if (params.size() != 1) {
-        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+Value ELang::Runtime::builtin_slice(const std::vector<Value>& params) {
+    if (params.size() != 3) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 3" << std::endl;
         throw -1;
     }
 
-    const auto val = params.at(0);
-
-    switch (val.type) {
-        case Type::Integer:
-            std::cout << std::get<long>(val.value) << " (type: Integer)";
-            break;
-        case Type::Float:
-            std::cout << std::get<double>(val.value) << " (type: Float)";
-            break;
-        case Type::Boolean:
-            std::cout << (std::get<bool>(val.value) ? "true" : "false") << " (type: Boolean)";
-            break;
-        case Type::String:
-            std::cout << "'" << *std::get<std::shared_ptr<std::string>>(val.value) << "' (type: String)";
-            break;
-        case Type::Void:
-            std::cout << " (type: Void)" << std::endl;
-            break;
-        case Type::Vector:
-            const auto vec = std::get<std::shared_ptr<std::vector<Value>>>(val.value);
-            std::cout << "Vector with " << vec->size() << " elements:" << std::endl;
-            for (std::size_t i = 0; i< vec->size(); ++i) {
-                std::cout << i << ": ";
-                const auto el = vec->at(i);
-
-                switch (el.type) {
-                    case Type::Integer:
-                        std::cout << std::get<long>(el.value) << " (type: Integer)";
-                        break;
-                    case Type::Float:
-                        std::cout << std::get<double>(el.value) << " (type: Float)";
-                        break;
-                    case Type::Boolean:
-                        std::cout << (std::get<bool>(el.value) ? "true" : "false") << " (type: Boolean)";
-                        break;
-                    case Type::String:
-                        std::cout << "'" << *std::get<std::shared_ptr<std::string>>(el.value) << "' (type: String)";
-                        break;
-                    case Type::Vector:
-                        std::cout << "(type: Vector)";
-                        break;
-                    default:
-                        break;
-                }
-
-                std::cout << std::endl;
-            }
-            break;
-    }
-
-    std::cout << std::endl;
-    return Value();
-}
-
-Value ELang::Runtime::builtin_substr(const std::vector<Value>& params) {
-    auto has_start = false;
-    Value start, len;
+    const auto seq = params.at(0);
+    const auto first = params.at(1);
+    const auto last = params.at(2);
 
-    if (params.size() == 2) {
-        len = params.at(1);
-    }
-    else if (params.size() == 3) {
-        has_start = true;
+    if ((seq.type == Type::Vector || seq.type == Type::String) && first.type == Type::Integer && last.type == Type::Integer) {
+        const auto length = seq.type == Type::Vector
+            ? std::get<std::shared_ptr<VectorSlice>>(seq.value)->length
+            : std::get<std::shared_ptr<StringSlice>>(seq.value)->length;
 
-        start = params.at(1);
-        len = params.at(2);
-    }
-    else {
-        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1 or 2" << std::endl;
-        throw -1;
-    }
+        /* 1-based, both ends inclusive like ranges */
+        const auto firstval = std::get<long>(first.value);
+        const auto lastval = std::get<long>(last.value);
 
-    const auto str = params.at(0);
+        // `v[n + 1:n]` is the empty slice at the end, anything further starts past it
+        if (firstval < 1 || firstval > static_cast<long>(length) + 1 || lastval > static_cast<long>(length)) {
+            std::cerr << "Out of bounds." << std::endl;
+            throw -1;
+        }
 
-    if (str.type == Type::String && len.type == Type::Integer && (!has_start || start.type == Type::Integer)) {
-        const auto full_str = std::get<std::shared_ptr<std::string>>(str.value);
-        const auto start_val = has_start ? std::get<long>(start.value) - 1 : 0;
+        const std::size_t offset = firstval - 1;
+        const std::size_t count = lastval >= firstval ? lastval - firstval + 1 : 0;
 
-        return Value(std::make_shared<std::string>(full_str->substr(start_val, std::get<long>(len.value))));
+        if (seq.type == Type::Vector) {
+            const auto vecval = std::get<std::shared_ptr<VectorSlice>>(seq.value);
+            return Value(std::make_shared<VectorSlice>(*vecval, offset, count));
+        }
+        else {
+            const auto strval = std::get<std::shared_ptr<StringSlice>>(seq.value);
+            return Value(std::make_shared<StringSlice>(*strval, offset, count));
+        }
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -672,22 +944,37 @@ Value ELang::Runtime::builtin_substr(const std::vector<Value>& params) {
     }
 }
 
-Value ELang::Runtime::builtin_lower(const std::vector<Value>& params) {
+Value ELang::Runtime::builtin_matrix(const std::vector<Value>& params) {
     if (params.size() != 1) {
         std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
         throw -1;
     }
 
-    const auto str = params.at(0);
-    
-    if (str.type == Type::String) {
-        const auto strval = std::get<std::shared_ptr<std::string>>(str.value);
-        std::string result;
+    const auto rows = params.at(0);
+
+    if (rows.type == Type::Vector) {
+        const auto rowsval = std::get<std::shared_ptr<VectorSlice>>(rows.value);
+        const auto first = rowsval->length > 0 ? rowsval->at(0) : Value();
+        const auto cols = first.type == Type::Vector ? std::get<std::shared_ptr<VectorSlice>>(first.value)->length : 0;
+        const auto result = std::make_shared<Matrix>(rowsval->length, cols);
+
+        for (std::size_t i = 0; i < rowsval->length; ++i) {
+            const auto row = rowsval->at(i);
+            if (row.type != Type::Vector || std::get<std::shared_ptr<VectorSlice>>(row.value)->length != cols) {
+                std::cerr << "Invalid matrix rows" << std::endl;
+                throw -1;
+            }
 
-        std::transform(strval->begin(), strval->end(), result.begin(),
-            [](unsigned char c){ return std::tolower(c); });
+            const auto rowval = std::get<std::shared_ptr<VectorSlice>>(row.value);
+            for (std::size_t j = 0; j < cols; ++j) {
+                if (!numeric_value(rowval->at(j), result->at(i, j))) {
+                    std::cerr << "Invalid matrix element" << std::endl;
+                    throw -1;
+                }
+            }
+        }
 
-        return Value(std::make_shared<std::string>(result));
+        return Value(result);
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -695,22 +982,16 @@ Value ELang::Runtime::builtin_lower(const std::vector<Value>& params) {
     }
 }
 
-Value ELang::Runtime::builtin_upper(const std::vector<Value>& params) {
+Value ELang::Runtime::builtin_rows(const std::vector<Value>& params) {
     if (params.size() != 1) {
         std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
         throw -1;
     }
 
-    const auto str = params.at(0);
-    
-    if (str.type == Type::String) {
-        const auto strval = std::get<std::shared_ptr<std::string>>(str.value);
-        std::string result;
-
-        std::transform(strval->begin(), strval->end(), result.begin(),
-            [](unsigned char c){ return std::toupper(c); });
+    const auto mat = params.at(0);
 
-        return Value(std::make_shared<std::string>(result));
+    if (mat.type == Type::Matrix) {
+        return Value(static_cast<long>(std::get<std::shared_ptr<Matrix>>(mat.value)->rows));
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -718,21 +999,16 @@ Value ELang::Runtime::builtin_upper(const std::vector<Value>& params) {
     }
 }
 
-Value ELang::Runtime::builtin_lower_bang(const std::vector<Value>& params) {
+Value ELang::Runtime::builtin_cols(const std::vector<Value>& params) {
     if (params.size() != 1) {
         std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
         throw -1;
     }
 
-    const auto str = params.at(0);
-    
-    if (str.type == Type::String) {
-        const auto strval = std::get<std::shared_ptr<std::string>>(str.value);
-
-        std::transform(strval->begin(), strval->end(), strval->begin(),
-            [](unsigned char c){ return std::tolower(c); });
+    const auto mat = params.at(0);
 
-        return Value(std::make_shared<std::string>(*strval));
+    if (mat.type == Type::Matrix) {
+        return Value(static_cast<long>(std::get<std::shared_ptr<Matrix>>(mat.value)->cols));
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -740,21 +1016,29 @@ Value ELang::Runtime::builtin_lower_bang(const std::vector<Value>& params) {
     }
 }
 
-Value ELang::Runtime::builtin_upper_bang(const std::vector<Value>& params) {
-    if (params.size() != 1) {
-        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+Value ELang::Runtime::builtin_set_bang(const std::vector<Value>& params) {
+    if (params.size() != 4) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 4" << std::endl;
         throw -1;
     }
 
-    const auto str = params.at(0);
-    
-    if (str.type == Type::String) {
-        const auto strval = std::get<std::shared_ptr<std::string>>(str.value);
+    const auto mat = params.at(0);
+    const auto row = params.at(1);
+    const auto col = params.at(2);
+    auto val = 0.0;
+
+    if (mat.type == Type::Matrix && row.type == Type::Integer && col.type == Type::Integer && numeric_value(params.at(3), val)) {
+        const auto matval = std::get<std::shared_ptr<Matrix>>(mat.value);
+        const auto rowval = std::get<long>(row.value);
+        const auto colval = std::get<long>(col.value);
 
-        std::transform(strval->begin(), strval->end(), strval->begin(),
-            [](unsigned char c){ return std::toupper(c); });
+        if (rowval < 1 || colval < 1 || rowval > static_cast<long>(matval->rows) || colval > static_cast<long>(matval->cols)) {
+            std::cerr << "Out of bounds." << std::endl;
+            throw -1;
+        }
 
-        return Value(std::make_shared<std::string>(*strval));
+        matval->at(rowval - 1, colval - 1) = val;
+        return mat;
     }
     else {
         std::cerr << "Invalid parameter types" << std::endl;
@@ -762,40 +1046,1021 @@ Value ELang::Runtime::builtin_upper_bang(const std::vector<Value>& params) {
     }
 }
 
-Value ELang::Runtime::builtin_split(const std::vector<Value>& params) {
-    const auto param_cnt = params.size();
-
-    if (param_cnt < 1 || param_cnt > 2) {
-        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1 or 2" << std::endl;
+Value ELang::Runtime::builtin_matmul(const std::vector<Value>& params) {
+    if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
         throw -1;
     }
 
-    const auto str = params.at(0);
+    const auto lhs = params.at(0);
+    const auto rhs = params.at(1);
 
-    if (str.type == Type::String) {
-        std::string separator = " ";
-        const auto strval = std::get<std::shared_ptr<std::string>>(str.value);
+    if (lhs.type == Type::Matrix && rhs.type == Type::Matrix) {
+        const auto lhsval = std::get<std::shared_ptr<Matrix>>(lhs.value);
+        const auto rhsval = std::get<std::shared_ptr<Matrix>>(rhs.value);
 
-        if (param_cnt == 2) {
-            const auto sep = params.at(1);
+        if (lhsval->cols != rhsval->rows) {
+            std::cerr << "Matrix dimensions do not match" << std::endl;
+            throw -1;
+        }
+
+        const auto result = std::make_shared<Matrix>(lhsval->rows, rhsval->cols);
+        matmul(*lhsval, *rhsval, *result);
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_transpose(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto mat = params.at(0);
+
+    if (mat.type == Type::Matrix) {
+        const auto matval = std::get<std::shared_ptr<Matrix>>(mat.value);
+        const auto result = std::make_shared<Matrix>(matval->cols, matval->rows);
+
+        transpose(*matval, *result);
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_rowsum(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto mat = params.at(0);
+
+    if (mat.type == Type::Matrix) {
+        return Value(float_vector(row_sums(*std::get<std::shared_ptr<Matrix>>(mat.value))));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_colsum(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto mat = params.at(0);
+
+    if (mat.type == Type::Matrix) {
+        return Value(float_vector(col_sums(*std::get<std::shared_ptr<Matrix>>(mat.value))));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_mask(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto vec = params.at(0);
+
+    if (vec.type == Type::Vector) {
+        const auto vecval = std::get<std::shared_ptr<VectorSlice>>(vec.value);
+        const auto result = std::make_shared<Mask>(vecval->length);
+
+        for (std::size_t i = 0; i < vecval->length; ++i) {
+            const auto& el = vecval->at(i);
+            if (el.type != Type::Boolean) {
+                std::cerr << "Invalid mask element" << std::endl;
+                throw -1;
+            }
+
+            if (std::get<bool>(el.value)) {
+                result->set(i);
+            }
+        }
+
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_count(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto mask = params.at(0);
+
+    if (mask.type == Type::Mask) {
+        const auto maskval = std::get<std::shared_ptr<Mask>>(mask.value);
+        return Value(static_cast<long>(Simd::popcount(maskval->words.data(), maskval->words.size())));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_any(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto mask = params.at(0);
+
+    if (mask.type == Type::Mask) {
+        const auto maskval = std::get<std::shared_ptr<Mask>>(mask.value);
+        return Value(std::any_of(maskval->words.cbegin(), maskval->words.cend(), [](const std::uint64_t word) { return word != 0; }));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_all(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto mask = params.at(0);
+
+    if (mask.type == Type::Mask) {
+        const auto maskval = std::get<std::shared_ptr<Mask>>(mask.value);
+        return Value(Simd::popcount(maskval->words.data(), maskval->words.size()) == maskval->length);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_show(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto val = params.at(0);
+    std::ostringstream out;
+
+    switch (val.type) {
+        case Type::Integer:
+            out << std::get<long>(val.value) << " (type: Integer)";
+            break;
+        case Type::Float:
+            out << std::get<double>(val.value) << " (type: Float)";
+            break;
+        case Type::Boolean:
+            out << (std::get<bool>(val.value) ? "true" : "false") << " (type: Boolean)";
+            break;
+        case Type::String:
+            out << "'" << std::get<std::shared_ptr<StringSlice>>(val.value)->view() << "' (type: String)";
+            break;
+        case Type::Void:
+            out << " (type: Void)" << '\n';
+            break;
+        case Type::Function:
+            out << std::get<std::shared_ptr<FunctionRef>>(val.value)->name << " (type: Function)";
+            break;
+        case Type::Generator:
+            out << std::get<std::shared_ptr<Generator>>(val.value)->name << " (type: Generator)";
+            break;
+        case Type::Task:
+            out << (std::get<std::shared_ptr<Task>>(val.value)->finished ? "finished" : "pending") << " (type: Task)";
+            break;
+        case Type::File:
+            out << std::get<std::shared_ptr<File>>(val.value)->path << " (type: File)";
+            break;
+        case Type::Mask: {
+            const auto mask = std::get<std::shared_ptr<Mask>>(val.value);
+            out << "Mask with " << mask->length << " elements:" << '\n';
+            for (std::size_t i = 0; i < mask->length; ++i) {
+                out << (mask->get(i) ? '1' : '0');
+            }
+            out << '\n';
+            break;
+        }
+        case Type::Matrix: {
+            const auto mat = std::get<std::shared_ptr<Matrix>>(val.value);
+            out << "Matrix with " << mat->rows << "x" << mat->cols << " elements:" << '\n';
+            for (std::size_t i = 0; i < mat->rows; ++i) {
+                for (std::size_t j = 0; j < mat->cols; ++j) {
+                    out << (j > 0 ? " " : "") << mat->at(i, j);
+                }
+                out << '\n';
+            }
+            break;
+        }
+        case Type::Vector:
+            const auto vec = std::get<std::shared_ptr<VectorSlice>>(val.value);
+            out << "Vector with " << vec->length << " elements:" << '\n';
+            for (std::size_t i = 0; i< vec->length; ++i) {
+                out << i << ": ";
+                const auto el = vec->at(i);
+
+                switch (el.type) {
+                    case Type::Integer:
+                        out << std::get<long>(el.value) << " (type: Integer)";
+                        break;
+                    case Type::Float:
+                        out << std::get<double>(el.value) << " (type: Float)";
+                        break;
+                    case Type::Boolean:
+                        out << (std::get<bool>(el.value) ? "true" : "false") << " (type: Boolean)";
+                        break;
+                    case Type::String:
+                        out << "'" << std::get<std::shared_ptr<StringSlice>>(el.value)->view() << "' (type: String)";
+                        break;
+                    case Type::Vector:
+                        out << "(type: Vector)";
+                        break;
+                    default:
+                        break;
+                }
+
+                out << '\n';
+            }
+            break;
+    }
+
+    out << '\n';
+
+    // one write per value, so lines from concurrent shows don't interleave
+    std::cout << out.str();
+    return Value();
+}
+
+Value ELang::Runtime::builtin_print(const std::vector<Value>& params) {
+    std::string out;
+    for (const auto& value: params) {
+        append_value(out, value, false);
+    }
+
+    std::cout << out;
+    return Value();
+}
+
+Value ELang::Runtime::builtin_println(const std::vector<Value>& params) {
+    std::string out;
+    for (const auto& value: params) {
+        append_value(out, value, false);
+    }
+    out.push_back('\n');
+
+    std::cout << out;
+    return Value();
+}
+
+Value ELang::Runtime::builtin_flush(const std::vector<Value>& params) {
+    if (params.size() > 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 0 or 1" << std::endl;
+        throw -1;
+    }
+
+    if (params.empty()) {
+        std::cout.flush();
+    }
+    else if (params.at(0).type == Type::File) {
+        const auto file = std::get<std::shared_ptr<File>>(params.at(0).value);
+        if (!file->flush()) {
+            file_error(file->path);
+        }
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+
+    return Value();
+}
+
+Value ELang::Runtime::builtin_buffering(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto mode = params.at(0);
+
+    if (mode.type == Type::String && std::get<std::shared_ptr<StringSlice>>(mode.value)->view() == "line") {
+        std::cout.flush();
+        set_buffering(Buffering::Line);
+    }
+    else if (mode.type == Type::String && std::get<std::shared_ptr<StringSlice>>(mode.value)->view() == "full") {
+        set_buffering(Buffering::Full);
+    }
+    else {
+        std::cerr << "Invalid buffering mode. Expected 'line' or 'full'" << std::endl;
+        throw -1;
+    }
+
+    return Value();
+}
+
+Value ELang::Runtime::builtin_open(const std::vector<Value>& params) {
+    if (params.size() != 1 && params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1 or 2" << std::endl;
+        throw -1;
+    }
+
+    const auto path = params.at(0);
+    const auto mode = params.size() == 2 ? params.at(1) : Value();
+
+    if (path.type != Type::String || (params.size() == 2 && mode.type != Type::String)) {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+
+    auto file_mode = File::Mode::Read;
+    if (params.size() == 2) {
+        const auto modeval = std::get<std::shared_ptr<StringSlice>>(mode.value)->view();
+
+        if (modeval == "w") {
+            file_mode = File::Mode::Write;
+        }
+        else if (modeval == "a") {
+            file_mode = File::Mode::Append;
+        }
+        else if (modeval != "r") {
+            std::cerr << "Invalid file mode. Expected 'r', 'w' or 'a'" << std::endl;
+            throw -1;
+        }
+    }
+
+    return Value(open_file(std::string(std::get<std::shared_ptr<StringSlice>>(path.value)->view()), file_mode));
+}
+
+Value ELang::Runtime::builtin_read(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto source = params.at(0);
+
+    if (source.type == Type::String || source.type == Type::File) {
+        // a view of the mapping, copied only if the script writes to it
+        return Value(std::make_shared<StringSlice>(*file_text(source)));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_readlines(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto source = params.at(0);
+
+    if (source.type == Type::String || source.type == Type::File) {
+        const auto text = file_text(source);
+        auto position = std::size_t(0);
+
+        // each line is a slice of the text without its line break
+        return Value(std::make_shared<Generator>("readlines", [text, position](Value& line) mutable {
+            const auto view = text->view();
+            if (position >= view.length()) {
+                return false;
+            }
+
+            const auto newline = view.find('\n', position);
+            const auto last = newline == std::string_view::npos ? view.length() : newline;
+            const auto length = last - position - (last > position && view[last - 1] == '\r' ? 1 : 0);
+
+            line = Value(std::make_shared<StringSlice>(*text, position, length));
+            position = last + 1;
+            return true;
+        }));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_write(const std::vector<Value>& params) {
+    if (params.size() < 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected at least 2" << std::endl;
+        throw -1;
+    }
+
+    const auto target = params.at(0);
+
+    if (target.type == Type::File) {
+        const auto file = std::get<std::shared_ptr<File>>(target.value);
+        std::string out;
+
+        for (auto it = params.cbegin() + 1; it != params.cend(); ++it) {
+            append_value(out, *it, false);
+        }
+
+        if (!file->write(out)) {
+            file_error(file->path);
+        }
+
+        return Value();
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_writeln(const std::vector<Value>& params) {
+    if (params.empty()) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected at least 1" << std::endl;
+        throw -1;
+    }
+
+    const auto target = params.at(0);
+
+    if (target.type == Type::File) {
+        const auto file = std::get<std::shared_ptr<File>>(target.value);
+        std::string out;
+
+        for (auto it = params.cbegin() + 1; it != params.cend(); ++it) {
+            append_value(out, *it, false);
+        }
+        out.push_back('\n');
+
+        if (!file->write(out)) {
+            file_error(file->path);
+        }
+
+        return Value();
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_close(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto target = params.at(0);
+
+    if (target.type == Type::File) {
+        const auto file = std::get<std::shared_ptr<File>>(target.value);
+        if (!file->close()) {
+            file_error(file->path);
+        }
+
+        return Value();
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_readnumbers(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto source = params.at(0);
+
+    if (source.type == Type::String || source.type == Type::File) {
+        const auto text = file_text(source);
+        const auto result = std::make_shared<std::vector<Value>>();
+        auto error = LoadError();
+
+        if (!load_numbers(text->view(), *result, error)) {
+            load_error(source, error);
+        }
+
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_readcsv(const std::vector<Value>& params) {
+    if (params.size() != 1 && params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1 or 2" << std::endl;
+        throw -1;
+    }
+
+    const auto source = params.at(0);
+    const auto separator = params.size() == 2 ? params.at(1) : Value();
+
+    if ((source.type == Type::String || source.type == Type::File)
+            && (params.size() == 1 || (separator.type == Type::String && std::get<std::shared_ptr<StringSlice>>(separator.value)->length == 1))) {
+        const auto text = file_text(source);
+        const auto sepval = params.size() == 2 ? std::get<std::shared_ptr<StringSlice>>(separator.value)->view()[0] : ',';
+        auto columns = std::vector<std::shared_ptr<std::vector<Value>>>();
+        auto error = LoadError();
+
+        if (!load_csv(text->view(), sepval, columns, error)) {
+            load_error(source, error);
+        }
+
+        const auto result = std::make_shared<std::vector<Value>>();
+        for (const auto& column: columns) {
+            result->push_back(Value(column));
+        }
+
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_save(const std::vector<Value>& params) {
+    if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
+        throw -1;
+    }
+
+    const auto path = params.at(0);
+
+    if (path.type == Type::String) {
+        const auto pathval = std::string(std::get<std::shared_ptr<StringSlice>>(path.value)->view());
+        auto contents = std::string();
+        auto error = std::string();
+
+        if (!save_value(params.at(1), contents, error)) {
+            std::cerr << "Error: can't save a value of type " << error << std::endl;
+            throw -1;
+        }
+
+        // File writes aside and renames over, a crash never leaves half a checkpoint
+        const auto file = open_file(pathval, File::Mode::Write);
+        if (!file->write(contents) || !file->close()) {
+            file_error(pathval);
+        }
+
+        return Value();
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_load(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto path = params.at(0);
+
+    if (path.type == Type::String) {
+        const auto pathval = std::string(std::get<std::shared_ptr<StringSlice>>(path.value)->view());
+        const auto file = MappedFile::open(pathval);
+        if (nullptr == file) {
+            file_error(pathval);
+        }
+
+        auto result = Value();
+        if (!load_value(file, result)) {
+            std::cerr << "Error: " << pathval << ": not a saved value" << std::endl;
+            throw -1;
+        }
+
+        return result;
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_attach(const std::vector<Value>& params) {
+    if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
+        throw -1;
+    }
+
+    const auto path = params.at(0);
+    const auto type = params.at(1);
+
+    if (path.type == Type::String && type.type == Type::String) {
+        const auto pathval = std::string(std::get<std::shared_ptr<StringSlice>>(path.value)->view());
+        const auto typeval = std::get<std::shared_ptr<StringSlice>>(type.value)->view();
+
+        if (typeval != "Integer" && typeval != "Float") {
+            std::cerr << "Invalid element type. Expected 'Integer' or 'Float'" << std::endl;
+            throw -1;
+        }
+
+        const auto file = MappedFile::open(pathval);
+        if (nullptr == file) {
+            file_error(pathval);
+        }
+        if (file->size % sizeof(std::int64_t) != 0) {
+            std::cerr << "Error: " << pathval << ": size is not a multiple of 8 bytes" << std::endl;
+            throw -1;
+        }
+
+        return Value(std::make_shared<VectorSlice>(std::shared_ptr<const MappedFile>(file), typeval == "Integer" ? Type::Integer : Type::Float));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+// nanoseconds on the steady clock, for differences only
+Value ELang::Runtime::builtin_time_ns(const std::vector<Value>& params) {
+    if (params.size() != 0) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 0" << std::endl;
+        throw -1;
+    }
+
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return Value(static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()));
+}
+
+Value ELang::Runtime::builtin_memstats(const std::vector<Value>& params) {
+    if (params.size() > 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 0 or 1" << std::endl;
+        throw -1;
+    }
+
+    const auto pair = [](const Memory::Usage& usage) {
+        return Value(std::make_shared<std::vector<Value>>(std::vector<Value>({ Value(static_cast<long>(usage.live)), Value(static_cast<long>(usage.peak)) })));
+    };
+
+    // `memstats('Vector')` is [live, peak] for one category
+    if (params.size() == 1) {
+        if (params.at(0).type != Type::String) {
+            std::cerr << "Invalid parameter types" << std::endl;
+            throw -1;
+        }
+
+        const auto category = std::get<std::shared_ptr<StringSlice>>(params.at(0).value)->view();
+        if (category == "total") {
+            return pair(Memory::total());
+        }
+
+        for (std::size_t i = 0; i < static_cast<std::size_t>(Memory::Category::Count); ++i) {
+            if (category == Memory::name(static_cast<Memory::Category>(i))) {
+                return pair(Memory::usage(static_cast<Memory::Category>(i)));
+            }
+        }
+
+        std::cerr << "Invalid memory category. Expected 'Vector', 'String', 'Context', 'Ast' or 'total'" << std::endl;
+        throw -1;
+    }
+
+    // `memstats()` is one [name, live, peak] row per category, then the total
+    const auto rows = std::make_shared<std::vector<Value>>();
+    const auto row = [&rows](const char* name, const Memory::Usage& usage) {
+        rows->push_back(Value(std::make_shared<std::vector<Value>>(std::vector<Value>({
+            Value(std::make_shared<std::string>(name)), Value(static_cast<long>(usage.live)), Value(static_cast<long>(usage.peak)) }))));
+    };
+
+    for (std::size_t i = 0; i < static_cast<std::size_t>(Memory::Category::Count); ++i) {
+        row(Memory::name(static_cast<Memory::Category>(i)), Memory::usage(static_cast<Memory::Category>(i)));
+    }
+    row("total", Memory::total());
+
+    return Value(rows);
+}
+
+Value ELang::Runtime::builtin_substr(const std::vector<Value>& params) {
+    auto has_start = false;
+    Value start, len;
+
+    if (params.size() == 2) {
+        len = params.at(1);
+    }
+    else if (params.size() == 3) {
+        has_start = true;
+
+        start = params.at(1);
+        len = params.at(2);
+    }
+    else {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1 or 2" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+
+    if (str.type == Type::String && len.type == Type::Integer && (!has_start || start.type == Type::Integer)) {
+        const auto full_str = std::get<std::shared_ptr<StringSlice>>(str.value);
+        const auto start_val = has_start ? std::get<long>(start.value) - 1 : 0;
+
+        // the result shares the source storage
+        const auto sub = full_str->view().substr(start_val, std::get<long>(len.value));
+        return Value(std::make_shared<StringSlice>(*full_str, start_val, sub.length()));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_lower(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+    
+    if (str.type == Type::String) {
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(str.value);
+        const auto result = std::make_shared<std::string>(strval->view());
+
+        Simd::to_lower(result->data(), result->length());
+
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_upper(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+    
+    if (str.type == Type::String) {
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(str.value);
+        const auto result = std::make_shared<std::string>(strval->view());
+
+        Simd::to_upper(result->data(), result->length());
+
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_lower_bang(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+    
+    if (str.type == Type::String) {
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(str.value);
+        auto& buffer = strval->detach();
+
+        Simd::to_lower(buffer.data(), buffer.length());
+
+        return Value(std::make_shared<std::string>(buffer));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_upper_bang(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+    
+    if (str.type == Type::String) {
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(str.value);
+        auto& buffer = strval->detach();
+
+        Simd::to_upper(buffer.data(), buffer.length());
+
+        return Value(std::make_shared<std::string>(buffer));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_split(const std::vector<Value>& params) {
+    const auto param_cnt = params.size();
+
+    if (param_cnt < 1 || param_cnt > 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1 or 2" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+
+    if (str.type == Type::String) {
+        std::string_view separator = " ";
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(str.value);
+
+        if (param_cnt == 2) {
+            const auto sep = params.at(1);
 
             if (sep.type != Type::String) {
                 std::cerr << "Invalid parameter types" << std::endl;
                 throw -1;
             }
 
-            separator = *std::get<std::shared_ptr<std::string>>(sep.value);
+            separator = std::get<std::shared_ptr<StringSlice>>(sep.value)->view();
+        }
+
+        if (separator.empty()) {
+            std::cerr << "Invalid separator" << std::endl;
+            throw -1;
         }
 
-        size_t pos = 0, prev_pos = 0;
+        // pieces are slices sharing the source storage, nothing is copied here
+        const auto source = strval->view();
         const auto result = std::make_shared<std::vector<Value>>();
-        while ((pos = strval->find(separator, prev_pos)) != std::string::npos) {
-            result->push_back(Value(std::make_shared<std::string>(strval->substr(prev_pos, pos - prev_pos))));
-            prev_pos = pos + 1;
+        std::size_t pos = 0, prev_pos = 0;
+
+        while ((pos = Simd::find(source, separator, prev_pos)) != std::string_view::npos) {
+            result->push_back(Value(std::make_shared<StringSlice>(*strval, prev_pos, pos - prev_pos)));
+            prev_pos = pos + separator.length();
+        }
+
+        if (prev_pos < source.length()) {
+            result->push_back(Value(std::make_shared<StringSlice>(*strval, prev_pos, source.length() - prev_pos)));
+        }
+
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_find(const std::vector<Value>& params) {
+    auto has_start = false;
+    Value start;
+
+    if (params.size() == 3) {
+        has_start = true;
+        start = params.at(2);
+    }
+    else if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2 or 3" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+    const auto sub = params.at(1);
+
+    if (str.type == Type::String && sub.type == Type::String && (!has_start || start.type == Type::Integer)) {
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(str.value)->view();
+        const auto subval = std::get<std::shared_ptr<StringSlice>>(sub.value)->view();
+        const auto start_val = has_start ? std::get<long>(start.value) - 1 : 0;
+
+        if (start_val < 0) {
+            std::cerr << "Out of bounds." << std::endl;
+            throw -1;
+        }
+
+        /* 1-based, 0 when not found */
+        const auto pos = Simd::find(strval, subval, start_val);
+        return Value(pos == std::string_view::npos ? 0l : static_cast<long>(pos + 1));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_contains(const std::vector<Value>& params) {
+    if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+    const auto sub = params.at(1);
+
+    if (str.type == Type::String && sub.type == Type::String) {
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(str.value)->view();
+        const auto subval = std::get<std::shared_ptr<StringSlice>>(sub.value)->view();
+
+        return Value(Simd::find(strval, subval) != std::string_view::npos);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_startswith(const std::vector<Value>& params) {
+    if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+    const auto prefix = params.at(1);
+
+    if (str.type == Type::String && prefix.type == Type::String) {
+        const auto strval = std::get<std::shared_ptr<StringSlice>>(str.value)->view();
+        const auto prefixval = std::get<std::shared_ptr<StringSlice>>(prefix.value)->view();
+
+        return Value(strval.substr(0, prefixval.length()) == prefixval);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_replace(const std::vector<Value>& params) {
+    if (params.size() != 3) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 3" << std::endl;
+        throw -1;
+    }
+
+    const auto str = params.at(0);
+    const auto from = params.at(1);
+    const auto to = params.at(2);
+
+    if (str.type == Type::String && from.type == Type::String && to.type == Type::String) {
+        const auto strslice = std::get<std::shared_ptr<StringSlice>>(str.value);
+        const auto strval = strslice->view();
+        const auto fromval = std::get<std::shared_ptr<StringSlice>>(from.value)->view();
+        const auto toval = std::get<std::shared_ptr<StringSlice>>(to.value)->view();
+
+        auto pos = fromval.empty() ? std::string_view::npos : Simd::find(strval, fromval);
+        if (pos == std::string_view::npos) {
+            // nothing to replace, share the source storage
+            return Value(std::make_shared<StringSlice>(*strslice));
         }
 
-        if (prev_pos < strval->length()) {
-            result->push_back(Value(std::make_shared<std::string>(strval->substr(prev_pos, pos - prev_pos))));
+        const auto result = std::make_shared<std::string>();
+        result->reserve(strval.length());
+
+        std::size_t prev_pos = 0;
+        do {
+            result->append(strval.substr(prev_pos, pos - prev_pos)).append(toval);
+            prev_pos = pos + fromval.length();
+        } while ((pos = Simd::find(strval, fromval, prev_pos)) != std::string_view::npos);
+
+        result->append(strval.substr(prev_pos));
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value ELang::Runtime::builtin_collect(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto gen = params.at(0);
+
+    if (gen.type == Type::Generator) {
+        const auto genval = std::get<std::shared_ptr<Generator>>(gen.value);
+        const auto result = std::make_shared<std::vector<Value>>();
+        auto element = Value();
+
+        while (genval->next(element)) {
+            result->push_back(element);
         }
 
         return Value(result);
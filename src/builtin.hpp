@@ -36,11 +36,51 @@ Value builtin_pop_bang(const std::vector<Value>& params);
 Value builtin_popat_bang(const std::vector<Value>& params);
 Value builtin_at(const std::vector<Value>& params);
 Value builtin_in(const std::vector<Value>& params);
+Value builtin_slice(const std::vector<Value>& params);
 // Value builtin_join(const std::vector<Value>& params);
 
+// matrices
+Value builtin_matrix(const std::vector<Value>& params);
+Value builtin_rows(const std::vector<Value>& params);
+Value builtin_cols(const std::vector<Value>& params);
+Value builtin_set_bang(const std::vector<Value>& params);
+Value builtin_matmul(const std::vector<Value>& params);
+Value builtin_transpose(const std::vector<Value>& params);
+Value builtin_rowsum(const std::vector<Value>& params);
+Value builtin_colsum(const std::vector<Value>& params);
+
+// masks
+Value builtin_mask(const std::vector<Value>& params);
+Value builtin_count(const std::vector<Value>& params);
+Value builtin_any(const std::vector<Value>& params);
+Value builtin_all(const std::vector<Value>& params);
+
 // pretty print
 Value builtin_show(const std::vector<Value>& params);
 
+// output
+Value builtin_print(const std::vector<Value>& params);
+Value builtin_println(const std::vector<Value>& params);
+Value builtin_flush(const std::vector<Value>& params);
+Value builtin_buffering(const std::vector<Value>& params);
+
+// files
+Value builtin_open(const std::vector<Value>& params);
+Value builtin_read(const std::vector<Value>& params);
+Value builtin_readlines(const std::vector<Value>& params);
+Value builtin_write(const std::vector<Value>& params);
+Value builtin_writeln(const std::vector<Value>& params);
+Value builtin_close(const std::vector<Value>& params);
+Value builtin_readnumbers(const std::vector<Value>& params);
+Value builtin_readcsv(const std::vector<Value>& params);
+Value builtin_save(const std::vector<Value>& params);
+Value builtin_load(const std::vector<Value>& params);
+Value builtin_attach(const std::vector<Value>& params);
+
+// runtime
+Value builtin_memstats(const std::vector<Value>& params);
+Value builtin_time_ns(const std::vector<Value>& params);
+
 // strings
 Value builtin_substr(const std::vector<Value>& params);
 Value builtin_lower(const std::vector<Value>& params);
@@ -48,6 +88,13 @@ Value builtin_upper(const std::vector<Value>& params);
 Value builtin_lower_bang(const std::vector<Value>& params);
 Value builtin_upper_bang(const std::vector<Value>& params);
 Value builtin_split(const std::vector<Value>& params);
+Value builtin_find(const std::vector<Value>& params);
+Value builtin_contains(const std::vector<Value>& params);
+Value builtin_startswith(const std::vector<Value>& params);
+Value builtin_replace(const std::vector<Value>& params);
+
+// generators
+Value builtin_collect(const std::vector<Value>& params);
 
 } // namespace Runtime
 } // namespace ELang
\ No newline at end of file
@@ -0,0 +1,509 @@
+#include "cache.hpp"
+#include "gen/parser.hpp"
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+using namespace ELang::Meta;
+
+namespace {
+
+enum Tag: std::uint8_t {
+    TagInteger = 1,
+    TagFloat,
+    TagBoolean,
+    TagString,
+    TagIdentifier,
+    TagArithmetic,
+    TagNegated,
+    TagBinary,
+    TagComparison,
+    TagCall,
+    TagVector,
+    TagRange,
+    TagSearch,
+    TagIndex,
+    TagExpressionStatement,
+    TagAssignment,
+    TagIf,
+    TagYield,
+    TagFor,
+    TagParallelFor,
+    TagWhile,
+    TagFunction,
+};
+
+class Writer {
+public:
+    explicit Writer(std::string& out): out(out) { }
+
+    void block(const Block* block) {
+        varint(block->statements.size());
+        for (const auto statement: block->statements) {
+            this->statement(statement);
+        }
+    }
+
+private:
+    std::string& out;
+    std::map<std::string, std::size_t> names;
+
+    void byte(const std::uint8_t value) {
+        out.push_back(static_cast<char>(value));
+    }
+
+    void varint(std::uint64_t value) {
+        while (value >= 0x80) {
+            byte(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        byte(static_cast<std::uint8_t>(value));
+    }
+
+    void integer(const long value) {
+        // zigzag, small negative numbers stay short
+        varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    void text(const std::string& value) {
+        varint(value.length());
+        out.append(value);
+    }
+
+    // every distinct name is written once, later uses refer to it by index
+    void name(const std::string& value) {
+        const auto it = names.find(value);
+        if (it != names.end()) {
+            varint(it->second);
+            return;
+        }
+
+        varint(names.size());
+        text(value);
+        names.emplace(value, names.size());
+    }
+
+    void optional_block(const Block* block) {
+        byte(nullptr != block);
+        if (nullptr != block) {
+            this->block(block);
+        }
+    }
+
+    void expressions(const std::vector<Expression*>& expressions) {
+        varint(expressions.size());
+        for (const auto expression: expressions) {
+            this->expression(*expression);
+        }
+    }
+
+    void expression(const Expression& expression) {
+        const auto expr_ptr = &expression;
+
+        if (const auto node = dynamic_cast<const Integer*>(expr_ptr)) {
+            byte(TagInteger);
+            integer(node->value);
+        }
+        else if (const auto node = dynamic_cast<const Float*>(expr_ptr)) {
+            char bytes[sizeof(double)];
+            std::memcpy(bytes, &node->value, sizeof(double));
+
+            byte(TagFloat);
+            out.append(bytes, sizeof(double));
+        }
+        else if (const auto node = dynamic_cast<const Boolean*>(expr_ptr)) {
+            byte(TagBoolean);
+            byte(node->value);
+        }
+        else if (const auto node = dynamic_cast<const String*>(expr_ptr)) {
+            byte(TagString);
+            text(node->value);
+        }
+        else if (const auto node = dynamic_cast<const Identifier*>(expr_ptr)) {
+            byte(TagIdentifier);
+            name(node->name);
+        }
+        else if (const auto node = dynamic_cast<const ArithmeticExpression*>(expr_ptr)) {
+            byte(TagArithmetic);
+            integer(node->op);
+            this->expression(node->lhs);
+            this->expression(node->rhs);
+        }
+        else if (const auto node = dynamic_cast<const NegatedBinaryExpression*>(expr_ptr)) {
+            byte(TagNegated);
+            this->expression(node->expr);
+        }
+        else if (const auto node = dynamic_cast<const BinaryExpression*>(expr_ptr)) {
+            byte(TagBinary);
+            integer(node->op);
+            this->expression(node->lhs);
+            this->expression(node->rhs);
+        }
+        else if (const auto node = dynamic_cast<const ComparisonExpression*>(expr_ptr)) {
+            byte(TagComparison);
+            integer(node->op);
+            this->expression(node->lhs);
+            this->expression(node->rhs);
+        }
+        else if (const auto node = dynamic_cast<const FunctionCall*>(expr_ptr)) {
+            byte(TagCall);
+            name(node->id.name);
+            expressions(node->arguments);
+        }
+        else if (const auto node = dynamic_cast<const VectorExpression*>(expr_ptr)) {
+            byte(TagVector);
+            expressions(node->arguments);
+        }
+        else if (const auto node = dynamic_cast<const RangeExpression*>(expr_ptr)) {
+            byte(TagRange);
+            this->expression(node->start);
+            this->expression(node->end);
+        }
+        else if (const auto node = dynamic_cast<const SearchExpression*>(expr_ptr)) {
+            byte(TagSearch);
+            this->expression(node->collection);
+            this->expression(node->element);
+        }
+        else if (const auto node = dynamic_cast<const IndexExpression*>(expr_ptr)) {
+            byte(TagIndex);
+            this->expression(node->identifier_expression);
+            this->expression(node->expression);
+            byte(nullptr != node->column_expression);
+            if (nullptr != node->column_expression) {
+                this->expression(*node->column_expression);
+            }
+        }
+        else {
+            throw std::logic_error("serialize: unknown expression");
+        }
+    }
+
+    void statement(const Statement* statement) {
+        varint(statement->line);
+
+        if (const auto node = dynamic_cast<const ExpressionStatement*>(statement)) {
+            byte(TagExpressionStatement);
+            expression(node->expression);
+        }
+        else if (const auto node = dynamic_cast<const Assignment*>(statement)) {
+            byte(TagAssignment);
+            name(node->id.name);
+            expression(node->expression);
+        }
+        else if (const auto node = dynamic_cast<const IfStatement*>(statement)) {
+            byte(TagIf);
+            expression(node->condition);
+            block(node->then_block);
+            optional_block(node->else_block);
+        }
+        else if (const auto node = dynamic_cast<const YieldStatement*>(statement)) {
+            byte(TagYield);
+            expression(node->expression);
+        }
+        // before ForLoop, which it derives from
+        else if (const auto node = dynamic_cast<const ParallelForLoop*>(statement)) {
+            byte(TagParallelFor);
+            name(node->id.name);
+            expression(node->iterator);
+            varint(node->reductions.size());
+            for (const auto reduction: node->reductions) {
+                name(reduction->operation.name);
+                name(reduction->id.name);
+            }
+            block(node->block);
+        }
+        else if (const auto node = dynamic_cast<const ForLoop*>(statement)) {
+            byte(TagFor);
+            name(node->id.name);
+            expression(node->iterator);
+            block(node->block);
+        }
+        else if (const auto node = dynamic_cast<const WhileLoop*>(statement)) {
+            byte(TagWhile);
+            expression(node->condition);
+            block(node->block);
+        }
+        else if (const auto node = dynamic_cast<const Function*>(statement)) {
+            byte(TagFunction);
+            name(node->id.name);
+            varint(node->params.size());
+            for (const auto param: node->params) {
+                name(param->id.name);
+                name(param->type.name);
+            }
+            block(node->block);
+        }
+        else {
+            throw std::logic_error("serialize: unknown statement");
+        }
+    }
+};
+
+// Any read past the end or unexpected tag throws, deserialize turns that into
+// nullptr. Nodes built before the failure are leaked, like a failed parse.
+class Reader {
+public:
+    Reader(const char* data, const std::size_t length): cursor(data), end(data + length) { }
+
+    Block* block() {
+        const auto block = new Block();
+        const auto count = varint();
+
+        for (std::uint64_t i = 0; i < count; ++i) {
+            block->statements.push_back(statement());
+        }
+
+        return block;
+    }
+
+    inline bool done() const { return cursor == end; }
+
+private:
+    const char* cursor;
+    const char* end;
+
+    // one node per distinct name, shared by every use: identifiers are never mutated
+    std::vector<Identifier*> names;
+
+    std::uint8_t byte() {
+        if (cursor == end) {
+            throw std::out_of_range("deserialize");
+        }
+
+        return static_cast<std::uint8_t>(*cursor++);
+    }
+
+    std::uint64_t varint() {
+        auto value = std::uint64_t(0);
+
+        for (auto shift = 0; shift < 64; shift += 7) {
+            const auto b = byte();
+            value |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return value;
+            }
+        }
+
+        throw std::out_of_range("deserialize");
+    }
+
+    long integer() {
+        const auto value = varint();
+        return static_cast<long>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    std::string_view text() {
+        const auto length = varint();
+        if (length > static_cast<std::uint64_t>(end - cursor)) {
+            throw std::out_of_range("deserialize");
+        }
+
+        const auto value = std::string_view(cursor, length);
+        cursor += length;
+        return value;
+    }
+
+    Identifier& name() {
+        const auto index = varint();
+        if (index < names.size()) {
+            return *names[index];
+        }
+        if (index > names.size()) {
+            throw std::out_of_range("deserialize");
+        }
+
+        names.push_back(new Identifier(text()));
+        return *names.back();
+    }
+
+    Block* optional_block() {
+        return byte() ? block() : nullptr;
+    }
+
+    std::vector<Expression*> expressions() {
+        const auto count = varint();
+        auto result = std::vector<Expression*>();
+
+        for (std::uint64_t i = 0; i < count; ++i) {
+            result.push_back(&expression());
+        }
+
+        return result;
+    }
+
+    Expression& expression() {
+        switch (byte()) {
+            case TagInteger:
+                return *new Integer(integer());
+            case TagFloat: {
+                auto value = 0.0;
+                if (static_cast<std::size_t>(end - cursor) < sizeof(double)) {
+                    throw std::out_of_range("deserialize");
+                }
+
+                std::memcpy(&value, cursor, sizeof(double));
+                cursor += sizeof(double);
+                return *new Float(value);
+            }
+            case TagBoolean:
+                return *new Boolean(byte() != 0);
+            case TagString: {
+                // String strips the quotes the lexer leaves on
+                const auto value = text();
+                return *new String("'" + std::string(value) + "'");
+            }
+            case TagIdentifier:
+                return name();
+            case TagArithmetic: {
+                const auto op = integer();
+                auto& lhs = expression();
+                return *new ArithmeticExpression(lhs, op, expression());
+            }
+            case TagNegated:
+                return *new NegatedBinaryExpression(expression());
+            case TagBinary: {
+                const auto op = integer();
+                auto& lhs = expression();
+                return *new BinaryExpression(lhs, op, expression());
+            }
+            case TagComparison: {
+                const auto op = integer();
+                auto& lhs = expression();
+                return *new ComparisonExpression(lhs, op, expression());
+            }
+            case TagCall: {
+                const auto& id = name();
+                return *new FunctionCall(id, expressions());
+            }
+            case TagVector: {
+                auto arguments = expressions();
+                return *new VectorExpression(arguments);
+            }
+            case TagRange: {
+                auto& start = expression();
+                return *new RangeExpression(start, expression());
+            }
+            case TagSearch: {
+                auto& collection = expression();
+                return *new SearchExpression(collection, expression());
+            }
+            case TagIndex: {
+                auto& identifier_expression = expression();
+                auto& index = expression();
+                const auto column = byte() ? &expression() : nullptr;
+                return *new IndexExpression(identifier_expression, index, column);
+            }
+            default:
+                throw std::out_of_range("deserialize");
+        }
+    }
+
+    Statement* statement() {
+        const auto line = static_cast<int>(varint());
+        const auto node = statement(byte());
+        node->line = line;
+        return node;
+    }
+
+    Statement* statement(const std::uint8_t tag) {
+        switch (tag) {
+            case TagExpressionStatement:
+                return new ExpressionStatement(expression());
+            case TagAssignment: {
+                const auto& id = name();
+                return new Assignment(id, expression());
+            }
+            case TagIf: {
+                auto& condition = expression();
+                const auto then_block = block();
+                return new IfStatement(condition, then_block, optional_block());
+            }
+            case TagYield:
+                return new YieldStatement(expression());
+            case TagParallelFor: {
+                const auto& id = name();
+                auto& iterator = expression();
+                auto reductions = std::vector<Reduction*>();
+
+                const auto count = varint();
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    const auto& operation = name();
+                    reductions.push_back(new Reduction(operation, name()));
+                }
+
+                return new ParallelForLoop(id, iterator, reductions, block());
+            }
+            case TagFor: {
+                const auto& id = name();
+                auto& iterator = expression();
+                return new ForLoop(id, iterator, block());
+            }
+            case TagWhile: {
+                auto& condition = expression();
+                return new WhileLoop(condition, block());
+            }
+            case TagFunction: {
+                const auto& id = name();
+                auto params = std::vector<TypedIdentifier*>();
+
+                const auto count = varint();
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    const auto& param = name();
+                    params.push_back(new TypedIdentifier(name(), param));
+                }
+
+                return new Function(id, params, block());
+            }
+            default:
+                throw std::out_of_range("deserialize");
+        }
+    }
+};
+
+inline std::uint64_t mix(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+} // namespace
+
+void ELang::Meta::serialize(const Block* program, std::string& out) {
+    Writer(out).block(program);
+}
+
+Block* ELang::Meta::deserialize(const char* data, const std::size_t length) {
+    try {
+        Reader reader(data, length);
+        const auto program = reader.block();
+        return reader.done() ? program : nullptr;
+    }
+    catch (const std::out_of_range&) {
+        return nullptr;
+    }
+}
+
+const char* ELang::Meta::build_stamp() {
+    return __DATE__ " " __TIME__;
+}
+
+std::uint64_t ELang::Meta::content_hash(const char* data, const std::size_t length) {
+    // a word at a time, this runs over whole scripts before every cached start
+    auto h = mix(length ^ 0x9e3779b97f4a7c15ULL);
+    auto i = std::size_t(0);
+
+    for (; i + sizeof(std::uint64_t) <= length; i += sizeof(std::uint64_t)) {
+        auto word = std::uint64_t(0);
+        std::memcpy(&word, data + i, sizeof(word));
+        h = (h ^ (word * 0x9fb21c651e98df25ULL)) * 0x87c37b91114253d5ULL;
+        h = (h << 31) | (h >> 33);
+    }
+
+    auto tail = std::uint64_t(0);
+    std::memcpy(&tail, data + i, length - i);
+    return mix(h ^ tail);
+}
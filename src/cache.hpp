@@ -0,0 +1,29 @@
+#pragma once
+
+#include "elang.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ELang {
+namespace Meta {
+
+// Compact binary form of a parsed program, what the on-disk program cache
+// stores. Nodes are written in pre-order behind a one byte tag, numbers as
+// varints and every distinct name once. Loading is a single pass over the
+// bytes that allocates the nodes directly: no lexing, no grammar.
+void serialize(const Block* program, std::string& out);
+
+// nullptr if the bytes are truncated or malformed
+Block* deserialize(const char* data, const std::size_t length);
+
+// when this encoder was compiled. It sees the AST and the token numbering,
+// so changing either rebuilds it and moves the stamp: entries written by
+// another build are misses even if nobody bumped the format
+const char* build_stamp();
+
+// cheap 64-bit content hash, used to key cache entries to their source
+std::uint64_t content_hash(const char* data, const std::size_t length);
+
+} // namespace Meta
+} // namespace ELang
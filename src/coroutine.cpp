@@ -0,0 +1,103 @@
+#include "coroutine.hpp"
+
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace ELang::Runtime;
+
+namespace {
+
+thread_local Coroutine* running = nullptr;
+
+std::size_t page_size() {
+    static const auto size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+} // namespace
+
+Coroutine::Coroutine(const std::function<void()>& body):
+    body(body), previous(nullptr), started(false), done(false), cancelled(false) {
+    // one extra page at the bottom, left inaccessible to catch overflows
+    stack = mmap(nullptr, stack_size + page_size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (MAP_FAILED == stack) {
+        throw std::bad_alloc();
+    }
+
+    mprotect(stack, page_size(), PROT_NONE);
+}
+
+Coroutine::~Coroutine() {
+    if (started && !done) {
+        // unwind the suspended body so whatever lives on its stack is released
+        cancelled = true;
+        try {
+            resume();
+        }
+        catch (...) {
+        }
+    }
+
+    munmap(stack, stack_size + page_size());
+}
+
+bool Coroutine::resume() {
+    if (done) {
+        return false;
+    }
+
+    if (!started) {
+        const auto self = reinterpret_cast<std::uintptr_t>(this);
+
+        getcontext(&context);
+        context.uc_stack.ss_sp = static_cast<char*>(stack) + page_size();
+        context.uc_stack.ss_size = stack_size;
+        context.uc_link = &caller;
+        makecontext(&context, reinterpret_cast<void (*)()>(&Coroutine::entry), 2,
+                    static_cast<unsigned int>(self >> 32), static_cast<unsigned int>(self & 0xffffffff));
+        started = true;
+    }
+
+    previous = running;
+    running = this;
+    swapcontext(&caller, &context);
+    running = previous;
+
+    if (error) {
+        const auto escaped = error;
+        error = nullptr;
+        std::rethrow_exception(escaped);
+    }
+
+    return !done;
+}
+
+void Coroutine::suspend() {
+    const auto self = running;
+
+    swapcontext(&self->context, &self->caller);
+    if (self->cancelled) {
+        throw Cancelled();
+    }
+}
+
+void Coroutine::entry(const unsigned int high, const unsigned int low) {
+    const auto self = reinterpret_cast<Coroutine*>((static_cast<std::uintptr_t>(high) << 32) | low);
+
+    try {
+        self->body();
+    }
+    catch (const Cancelled&) {
+    }
+    catch (...) {
+        self->error = std::current_exception();
+    }
+
+    // release the captures while still on this stack
+    self->body = nullptr;
+    self->done = true;
+
+    // returning resumes uc_link, i.e. the last caller
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <ucontext.h>
+
+namespace ELang {
+namespace Runtime {
+
+// Stackful coroutine on top of ucontext. `body` runs on a stack of its own and
+// can hand control back to whoever resumed it from any call depth, which is
+// what a recursive tree walker needs to pause in the middle of a statement.
+// Only one thread may resume a given coroutine at a time.
+class Coroutine {
+public:
+    // reserved address space, pages are committed as the body touches them
+    static constexpr std::size_t stack_size = 8 << 20;
+
+    explicit Coroutine(const std::function<void()>& body);
+    ~Coroutine();
+
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+
+    // run until the body suspends (true) or returns (false), rethrowing
+    // whatever escaped from it
+    bool resume();
+    inline bool finished() const { return done; }
+
+    // called from inside a body: hand control back to the resumer
+    static void suspend();
+
+private:
+    // thrown out of `suspend` to unwind a body that will never be resumed
+    class Cancelled { };
+
+    std::function<void()> body;
+    ucontext_t context;
+    ucontext_t caller;
+    void* stack;
+    Coroutine* previous;
+    std::exception_ptr error;
+    bool started;
+    bool done;
+    bool cancelled;
+
+    static void entry(const unsigned int high, const unsigned int low);
+};
+
+} // namespace Runtime
+} // namespace ELang
@@ -1,20 +1,52 @@
 #pragma once
 
+#include <charconv>
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace ELang {
+namespace Runtime {
+class Value;
+} // namespace Runtime
+
 namespace Meta {
 
+// Text of a token, pointing into the buffer being parsed. Plain data so it can
+// live in the parser's value union; nodes copy out whatever they keep.
+struct Lexeme {
+    const char* data;
+    std::size_t length;
+
+    inline std::string_view view() const { return std::string_view(data, length); }
+
+    // false, leaving `value` alone, when the literal does not fit
+    inline bool to_integer(long& value) const {
+        return std::from_chars(data, data + length, value).ec == std::errc();
+    }
+
+    inline bool to_float(double& value) const {
+        return std::from_chars(data, data + length, value).ec == std::errc();
+    }
+};
+
 class Node {
 public:
     virtual ~Node() {}
+
+    // counted as AST memory by Runtime::Memory, see memory.cpp
+    static void* operator new(const std::size_t size);
+    static void operator delete(void* node, const std::size_t size);
 };
 
 class Expression: public Node {
 };
 
 class Statement: public Node {
+public:
+    // first source line, 0 when unknown
+    int line = 0;
 };
 
 class Integer: public Expression {
@@ -42,23 +74,29 @@ class String: public Expression {
 public:
     const std::string value;
 
-    inline std::string parse_string(const std::string& input) {
+    inline std::string parse_string(const std::string_view input) {
         if (input.length() > 2) {
-            return input.substr(1, input.length() - 2);
+            return std::string(input.substr(1, input.length() - 2));
         }
         else {
-            return input;
+            return std::string(input);
         }
     }
 
-    String(const std::string& v): value(parse_string(v)) { }
+    String(const std::string_view v): value(parse_string(v)) { }
 };
 
+// An operator resolved by Runtime::infer_types for the operand types it
+// found: computes the builtin's result straight from the operands. Returns
+// false, leaving `result` alone, when they turn out to be other types.
+typedef bool (*Kernel)(const Runtime::Value& lhs, const Runtime::Value& rhs, Runtime::Value& result);
+
 class ArithmeticExpression: public Expression {
 public:
     const int op;
     Expression& lhs;
     Expression& rhs;
+    Kernel kernel = nullptr;
 
     ArithmeticExpression(Expression& lhs, const int op, Expression& rhs):
         op(op), lhs(lhs), rhs(rhs) { }
@@ -76,6 +114,7 @@ public:
     const int op;
     Expression& lhs;
     Expression& rhs;
+    Kernel kernel = nullptr;
 
     BinaryExpression(Expression& lhs, const int op, Expression& rhs):
         op(op), lhs(lhs), rhs(rhs) { }
@@ -86,6 +125,7 @@ public:
     const int op;
     Expression& lhs;
     Expression& rhs;
+    Kernel kernel = nullptr;
 
     ComparisonExpression(Expression& lhs, const int op, Expression& rhs):
         op(op), lhs(lhs), rhs(rhs) { }
@@ -111,7 +151,7 @@ public:
     std::string name;
 
     Identifier(): name() { }
-    Identifier(const std::string& name): name(name) { }
+    Identifier(const std::string_view name): name(name) { }
 };
 
 class FunctionCall: public Expression {
@@ -151,9 +191,12 @@ class IndexExpression: public Expression {
 public:
     Expression& identifier_expression;
     Expression& expression;
+    Expression* column_expression;
 
     IndexExpression(Expression& identifier_expression, Expression& expression):
-        identifier_expression(identifier_expression), expression(expression) { }
+        identifier_expression(identifier_expression), expression(expression), column_expression(nullptr) { }
+    IndexExpression(Expression& identifier_expression, Expression& expression, Expression* column_expression):
+        identifier_expression(identifier_expression), expression(expression), column_expression(column_expression) { }
 };
 
 class TypedIdentifier: public Expression {
@@ -181,11 +224,19 @@ public:
     Block* else_block;
 
     IfStatement(Expression& condition, Block* then_block):
-        condition(condition), then_block(then_block) { }
+        condition(condition), then_block(then_block), else_block(nullptr) { }
     IfStatement(Expression& condition, Block* then_block, Block* else_block):
         condition(condition), then_block(then_block), else_block(else_block) { }
 };
 
+class YieldStatement: public Statement {
+public:
+    Expression& expression;
+
+    YieldStatement(Expression& expression):
+        expression(expression) { }
+};
+
 class ForLoop: public Statement {
 public:
     const Identifier& id;
@@ -196,6 +247,25 @@ public:
         id(id), iterator(iterator), block(block) { }
 };
 
+// `sum(a)` in `parallel for i in v with sum(a)`: how the private copies of
+// `a` are merged back once every chunk is done
+class Reduction: public Node {
+public:
+    const Identifier& operation;
+    const Identifier& id;
+
+    Reduction(const Identifier& operation, const Identifier& id):
+        operation(operation), id(id) { }
+};
+
+class ParallelForLoop: public ForLoop {
+public:
+    std::vector<Reduction*> reductions;
+
+    ParallelForLoop(const Identifier& id, Expression& iterator, std::vector<Reduction*>& reductions, Block* block):
+        ForLoop(id, iterator, block), reductions(reductions) { }
+};
+
 class WhileLoop: public Statement {
 public:
     Expression& condition;
@@ -215,5 +285,18 @@ public:
         id(id), params(params), block(block) { }
 };
 
+// Parses a whole program out of `source`, nullptr on a syntax error. Every
+// call owns its scanner and parser state, so threads can parse concurrently.
+Block* parse(const char* source, const std::size_t length);
+
+inline Block* parse(const std::string& source) {
+    return parse(source.data(), source.length());
+}
+
+// Same, but scans `source` where it is instead of copying it first. The buffer
+// must be writable and followed by two NUL bytes (source[length] and
+// source[length + 1]): the scanner terminates tokens in place while it runs.
+Block* parse_in_place(char* source, const std::size_t length);
+
 } // namespace Meta
 } // namespace ELang
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include "elc.hpp"
+#include "cache.hpp"
+#include "infer.hpp"
+#include "mapped.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+#include <unistd.h>
+
+using namespace ELang;
+using namespace ELang::Runtime;
+
+namespace {
+
+// bump whenever the AST, the token numbering or the encoding in cache.cpp changes
+constexpr std::uint32_t cache_format = 2;
+
+// Cache files start with this header; anything else, or a different source,
+// compiler, build or format, is a miss. The source hash sits in the header so a
+// stale entry is rejected before any node is built.
+std::string cache_header(const std::uint64_t source_hash) {
+    auto header = std::string("ELCC");
+    header.append(reinterpret_cast<const char*>(&cache_format), sizeof(cache_format));
+    header.append(reinterpret_cast<const char*>(&source_hash), sizeof(source_hash));
+    header.append(version).push_back('\0');
+    header.append(Meta::build_stamp()).push_back('\0');
+    return header;
+}
+
+Meta::Block* load_cache(const std::string& path, const std::string& header) {
+    const auto file = MappedFile::open(path);
+    if (nullptr == file || file->size < header.length() || std::memcmp(file->data, header.data(), header.length()) != 0) {
+        return nullptr;
+    }
+
+    return Meta::deserialize(file->data + header.length(), file->size - header.length());
+}
+
+// best effort: a read-only directory just means no cache
+void store_cache(const std::string& path, const std::string& header, const Meta::Block* program) {
+    auto contents = header;
+    Meta::serialize(program, contents);
+
+    // written aside and renamed over, readers never see half a file
+    const auto temporary = path + "." + std::to_string(getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.write(contents.data(), contents.length())) {
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+// every node reachable from `node`, once: deserialized programs share one
+// Identifier per distinct name
+void collect_nodes(const Meta::Node* node, std::unordered_set<const Meta::Node*>& nodes) {
+    using namespace Meta;
+
+    if (nullptr == node || !nodes.insert(node).second) {
+        return;
+    }
+
+    if (const auto block = dynamic_cast<const Block*>(node)) {
+        for (const auto statement: block->statements) {
+            collect_nodes(statement, nodes);
+        }
+    }
+    else if (const auto arithmetic = dynamic_cast<const ArithmeticExpression*>(node)) {
+        collect_nodes(&arithmetic->lhs, nodes);
+        collect_nodes(&arithmetic->rhs, nodes);
+    }
+    else if (const auto comparison = dynamic_cast<const ComparisonExpression*>(node)) {
+        collect_nodes(&comparison->lhs, nodes);
+        collect_nodes(&comparison->rhs, nodes);
+    }
+    else if (const auto binary = dynamic_cast<const BinaryExpression*>(node)) {
+        collect_nodes(&binary->lhs, nodes);
+        collect_nodes(&binary->rhs, nodes);
+    }
+    else if (const auto negated = dynamic_cast<const NegatedBinaryExpression*>(node)) {
+        collect_nodes(&negated->expr, nodes);
+    }
+    else if (const auto call = dynamic_cast<const FunctionCall*>(node)) {
+        collect_nodes(&call->id, nodes);
+        for (const auto argument: call->arguments) {
+            collect_nodes(argument, nodes);
+        }
+    }
+    else if (const auto vector = dynamic_cast<const VectorExpression*>(node)) {
+        for (const auto argument: vector->arguments) {
+            collect_nodes(argument, nodes);
+        }
+    }
+    else if (const auto range = dynamic_cast<const RangeExpression*>(node)) {
+        collect_nodes(&range->start, nodes);
+        collect_nodes(&range->end, nodes);
+    }
+    else if (const auto search = dynamic_cast<const SearchExpression*>(node)) {
+        collect_nodes(&search->collection, nodes);
+        collect_nodes(&search->element, nodes);
+    }
+    else if (const auto index = dynamic_cast<const IndexExpression*>(node)) {
+        collect_nodes(&index->identifier_expression, nodes);
+        collect_nodes(&index->expression, nodes);
+        collect_nodes(index->column_expression, nodes);
+    }
+    else if (const auto typed = dynamic_cast<const TypedIdentifier*>(node)) {
+        collect_nodes(&typed->type, nodes);
+        collect_nodes(&typed->id, nodes);
+    }
+    else if (const auto expression_statement = dynamic_cast<const ExpressionStatement*>(node)) {
+        collect_nodes(&expression_statement->expression, nodes);
+    }
+    else if (const auto assignment = dynamic_cast<const Assignment*>(node)) {
+        collect_nodes(&assignment->id, nodes);
+        collect_nodes(&assignment->expression, nodes);
+    }
+    else if (const auto if_statement = dynamic_cast<const IfStatement*>(node)) {
+        collect_nodes(&if_statement->condition, nodes);
+        collect_nodes(if_statement->then_block, nodes);
+        collect_nodes(if_statement->else_block, nodes);
+    }
+    else if (const auto yield_statement = dynamic_cast<const YieldStatement*>(node)) {
+        collect_nodes(&yield_statement->expression, nodes);
+    }
+    else if (const auto for_loop = dynamic_cast<const ForLoop*>(node)) {
+        collect_nodes(&for_loop->id, nodes);
+        collect_nodes(&for_loop->iterator, nodes);
+        collect_nodes(for_loop->block, nodes);
+
+        if (const auto parallel_loop = dynamic_cast<const ParallelForLoop*>(node)) {
+            for (const auto reduction: parallel_loop->reductions) {
+                collect_nodes(reduction, nodes);
+            }
+        }
+    }
+    else if (const auto reduction = dynamic_cast<const Reduction*>(node)) {
+        collect_nodes(&reduction->operation, nodes);
+        collect_nodes(&reduction->id, nodes);
+    }
+    else if (const auto while_loop = dynamic_cast<const WhileLoop*>(node)) {
+        collect_nodes(&while_loop->condition, nodes);
+        collect_nodes(while_loop->block, nodes);
+    }
+    else if (const auto function = dynamic_cast<const Function*>(node)) {
+        collect_nodes(&function->id, nodes);
+        for (const auto param: function->params) {
+            collect_nodes(param, nodes);
+        }
+        collect_nodes(function->block, nodes);
+    }
+}
+
+} // namespace
+
+Program::~Program() {
+    // nodes only refer to their children, deleting them in any order is fine
+    auto nodes = std::unordered_set<const Meta::Node*>();
+    collect_nodes(program, nodes);
+
+    for (const auto node: nodes) {
+        delete node;
+    }
+}
+
+std::shared_ptr<const Program> Program::compile(const char* source, const std::size_t length) {
+    const auto program = Meta::parse(source, length);
+    if (nullptr == program) {
+        return nullptr;
+    }
+
+    infer_types(program);
+
+    return std::shared_ptr<const Program>(new Program(program));
+}
+
+std::shared_ptr<const Program> Program::compile(const std::string& source) {
+    return compile(source.data(), source.length());
+}
+
+std::shared_ptr<const Program> Program::compile_file(const std::string& path, const bool use_cache) {
+    const auto file = MappedFile::open(path, 2);
+    if (nullptr == file) {
+        std::cerr << "Error: " << path << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    const auto cache_path = path + "c";
+    const auto header = use_cache ? cache_header(Meta::content_hash(file->data, file->size)) : std::string();
+
+    if (use_cache) {
+        const auto cached = load_cache(cache_path, header);
+        if (nullptr != cached) {
+            infer_types(cached);
+            return std::shared_ptr<const Program>(new Program(cached));
+        }
+    }
+
+    // the AST copies what it keeps, the mapping can go once parsing is done
+    const auto program = Meta::parse_in_place(file->data, file->size);
+    if (nullptr == program) {
+        return nullptr;
+    }
+
+    if (use_cache) {
+        store_cache(cache_path, header, program);
+    }
+
+    infer_types(program);
+
+    return std::shared_ptr<const Program>(new Program(program));
+}
+
+Engine::Engine() {
+    interpreter.register_builtins();
+}
+
+void Engine::register_builtin(const std::string& name, const std::vector<Argument>& arguments,
+                              const std::function<Value(std::vector<Value>&)>& callable, const bool variadic) {
+    interpreter.global_context->register_method(std::shared_ptr<Method>(new BuiltinMethod(name, arguments, callable, variadic)));
+}
+
+Value Engine::run(const Program& program, const std::map<std::string, Value>& bindings) {
+    const auto context = std::make_shared<Context>(interpreter.global_context);
+
+    for (const auto& binding: bindings) {
+        context->assign_variable(binding.first, binding.second, true);
+    }
+
+    // also on a runtime error: unfetched tasks may still print into the caller's capture
+    class Drain {
+    public:
+        explicit Drain(Interpreter& interpreter): interpreter(interpreter) { }
+        ~Drain() { interpreter.wait_for_tasks(); }
+
+    private:
+        Interpreter& interpreter;
+    };
+
+    const Drain drain(interpreter);
+    const Profile::Frame frame(Profile::declare("(main)"));
+    return interpreter.run(program.block(), context);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "elang.hpp"
+#include "vm.hpp"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ELang {
+
+constexpr const char* version = "0.1p0";
+
+// A parsed script. Immutable once compiled, so a single Program can be run by
+// any number of engines and threads at the same time. It owns its AST, freed
+// with it: values a run returns that hold the script's functions, tasks or
+// generators must not outlive it.
+class Program {
+public:
+    ~Program();
+
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+    // nullptr on a syntax error
+    static std::shared_ptr<const Program> compile(const char* source, const std::size_t length);
+    static std::shared_ptr<const Program> compile(const std::string& source);
+
+    // maps the file and lexes it in place; nullptr if it can't be read
+    // (reported on stderr) or has a syntax error. With `use_cache`, a compiled
+    // copy is kept next to the source (`script.e` -> `script.ec`) and reused
+    // for as long as the source and the compiler stay the same.
+    static std::shared_ptr<const Program> compile_file(const std::string& path, const bool use_cache = true);
+
+    inline const Meta::Block* block() const { return program; }
+
+private:
+    const Meta::Block* program;
+
+    explicit Program(const Meta::Block* program): program(program) { }
+};
+
+// An interpreter with the builtins registered once, running prepared programs.
+// Every run gets a fresh top-level frame below the builtins, so nothing a
+// script defines or assigns leaks into the next run. Register host builtins
+// before the first run; after that, `run` may be called from several threads.
+class Engine {
+public:
+    Engine();
+
+    void register_builtin(const std::string& name, const std::vector<Runtime::Argument>& arguments,
+                          const std::function<Runtime::Value(std::vector<Runtime::Value>&)>& callable, const bool variadic = false);
+
+    // `bindings` become top-level variables of this run only. Returns the last
+    // evaluated value; runtime errors propagate as the interpreter throws them.
+    // Either way only once the tasks the engine spawned are done, so a run
+    // never outlives its output capture.
+    Runtime::Value run(const Program& program, const std::map<std::string, Runtime::Value>& bindings = {});
+
+private:
+    Runtime::Interpreter interpreter;
+};
+
+} // namespace ELang
@@ -0,0 +1,230 @@
+#include "file.hpp"
+#include "output.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ELang::Runtime;
+
+namespace {
+
+constexpr std::size_t block_size = 1 << 20;
+
+// tells apart the staging files of one process
+std::atomic<std::uint64_t> staged(0);
+
+// files open for writing, for close_all
+std::mutex open_mutex;
+std::set<File*> open_files;
+
+void track(File* file) {
+    std::lock_guard<std::mutex> lock(open_mutex);
+    open_files.insert(file);
+}
+
+void forget(File* file) {
+    std::lock_guard<std::mutex> lock(open_mutex);
+    open_files.erase(file);
+}
+
+// for what can't be mapped: pipes, terminals, /proc
+std::shared_ptr<std::string> read_blocks(const int fd) {
+    const auto text = std::make_shared<std::string>();
+
+    for (;;) {
+        const auto used = text->size();
+        text->resize(used + block_size);
+
+        const auto count = ::read(fd, text->data() + used, block_size);
+        if (count < 0 && errno == EINTR) {
+            text->resize(used);
+            continue;
+        }
+
+        text->resize(used + (count > 0 ? count : 0));
+        if (count < 0) {
+            return nullptr;
+        }
+        if (count == 0) {
+            return text;
+        }
+    }
+}
+
+} // namespace
+
+std::shared_ptr<File> File::open(const std::string& path, const Mode mode) {
+    const auto file = std::shared_ptr<File>(new File(path, mode));
+
+    if (mode == Mode::Append) {
+        file->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | O_APPEND, 0644);
+        if (file->fd < 0) {
+            return nullptr;
+        }
+
+        file->pending.reserve(capacity);
+        track(file.get());
+        return file;
+    }
+
+    if (mode == Mode::Write) {
+        // through symlinks, so the rename replaces what the link points at
+        const auto resolved = ::realpath(path.c_str(), nullptr);
+        file->target = nullptr != resolved ? std::string(resolved) : path;
+        std::free(resolved);
+
+        // only an existing regular file can be mapped by someone; devices,
+        // FIFOs and new files are written where they are
+        struct stat existing;
+        if (stat(file->target.c_str(), &existing) == 0 && S_ISREG(existing.st_mode)) {
+            file->staging = file->target + ".~" + std::to_string(getpid()) + "." + std::to_string(++staged);
+            file->fd = ::open(file->staging.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            if (file->fd < 0) {
+                file->staging.clear();
+                return nullptr;
+            }
+
+            fchmod(file->fd, existing.st_mode & 07777);
+        }
+        else {
+            file->fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (file->fd < 0) {
+                return nullptr;
+            }
+        }
+
+        file->pending.reserve(capacity);
+        track(file.get());
+        return file;
+    }
+
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return nullptr;
+    }
+
+    if (S_ISREG(info.st_mode)) {
+        const auto mapping = MappedFile::open(path);
+        if (nullptr == mapping) {
+            return nullptr;
+        }
+
+        file->contents = std::make_shared<StringSlice>(std::shared_ptr<const MappedFile>(mapping));
+        return file;
+    }
+
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    const auto text = read_blocks(fd);
+    const auto error = errno;
+    ::close(fd);
+
+    if (nullptr == text) {
+        errno = error;
+        return nullptr;
+    }
+
+    file->contents = std::make_shared<StringSlice>(text);
+    return file;
+}
+
+File::~File() {
+    close();
+}
+
+bool File::write(const std::string_view data) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (fd < 0) {
+        errno = 0;
+        return false;
+    }
+
+    if (pending.size() + data.size() > capacity && !drain()) {
+        return false;
+    }
+
+    if (data.size() >= capacity) {
+        return write_fully(fd, data.data(), data.size());
+    }
+
+    pending.append(data);
+    return true;
+}
+
+bool File::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fd < 0 || (drain() && publish());
+}
+
+void File::close_all() {
+    // held throughout: a file being destroyed meanwhile waits in `forget`
+    std::lock_guard<std::mutex> lock(open_mutex);
+    for (const auto file: open_files) {
+        std::lock_guard<std::mutex> file_lock(file->mutex);
+        file->shut();
+    }
+    open_files.clear();
+}
+
+bool File::close() {
+    // before taking `mutex`, the order close_all takes them in
+    forget(this);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return shut();
+}
+
+bool File::shut() {
+    // whatever was read stays alive in the strings already handed out
+    contents = nullptr;
+    if (fd < 0) {
+        return true;
+    }
+
+    const auto drained = drain();
+    const auto published = drained && publish();
+    auto closed = ::close(fd) == 0;
+    fd = -1;
+
+    if (!staging.empty()) {
+        // the path keeps its old contents rather than half the new ones
+        const auto error = errno;
+        std::remove(staging.c_str());
+        errno = error;
+        staging.clear();
+    }
+
+    return drained && published && closed;
+}
+
+bool File::publish() {
+    if (staging.empty()) {
+        return true;
+    }
+
+    // from here on the descriptor writes into the file at the path, a fresh
+    // inode that nothing has mapped yet
+    if (std::rename(staging.c_str(), target.c_str()) != 0) {
+        return false;
+    }
+
+    staging.clear();
+    return true;
+}
+
+bool File::drain() {
+    const auto ok = write_fully(fd, pending.data(), pending.size());
+    pending.clear();
+    return ok;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "vm.hpp"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace ELang {
+namespace Runtime {
+
+// A file opened by a script. Reading takes the whole file at open, mapped
+// (or read in large blocks when it can't be mapped, e.g. a pipe), and hands it
+// out as string views, so lines cost no copies. Writes collect in a buffer
+// that goes out a block at a time, on `flush` and on `close`.
+//
+// Strings read from a file must not change under the script, nor fault if
+// the file shrinks: opening an existing regular file with 'w' therefore
+// writes beside it, renamed over the path on the first `flush` or on `close`,
+// leaving earlier mappings on the old inode. Until then the path keeps its
+// previous contents. Devices, FIFOs and new files are written in place, and
+// appending never shrinks a file.
+class File {
+public:
+    enum class Mode { Read, Write, Append };
+
+    const std::string path;
+    const Mode mode;
+
+    // nullptr if it can't be opened, with errno set
+    static std::shared_ptr<File> open(const std::string& path, const Mode mode);
+
+    ~File();
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    // the contents of a file opened for reading, nullptr otherwise
+    inline std::shared_ptr<StringSlice> text() const { return contents; }
+
+    // false (with errno set) once a write fails; false with errno 0 when the
+    // file isn't open for writing
+    bool write(const std::string_view data);
+    bool flush();
+    bool close();
+
+    // closes every file still open for writing, for exits that skip their
+    // destructors, e.g. a script failing with values still referenced
+    static void close_all();
+
+private:
+    static constexpr std::size_t capacity = 256 * 1024;
+
+    std::shared_ptr<StringSlice> contents;
+    int fd;
+    std::string target;  // what `staging` replaces on close, `path` resolved
+    std::string staging; // written instead of `target` until published, else empty
+    std::string pending;
+    std::mutex mutex;
+
+    File(const std::string& path, const Mode mode): path(path), mode(mode), fd(-1) { }
+
+    bool drain();
+    bool publish();
+    bool shut();
+};
+
+} // namespace Runtime
+} // namespace ELang
@@ -0,0 +1,454 @@
+#include "infer.hpp"
+#include "vm.hpp"
+#include "gen/parser.hpp"
+
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+using namespace ELang::Runtime;
+using namespace ELang::Meta;
+
+namespace {
+
+// Static types are runtime Types: Void for a local whose assignments are not
+// resolved yet, Any for one that can hold anything.
+typedef std::unordered_map<std::string, Type> Scope;
+
+template <typename T> constexpr Type type_of();
+template <> constexpr Type type_of<long>() { return Type::Integer; }
+template <> constexpr Type type_of<double>() { return Type::Float; }
+template <> constexpr Type type_of<bool>() { return Type::Boolean; }
+
+// `lhs op rhs` on the unwrapped operands, computed the way the builtin does
+template <typename L, typename R, typename Op>
+bool kernel(const Value& lhs, const Value& rhs, Value& result) {
+    if (lhs.type != type_of<L>() || rhs.type != type_of<R>()) {
+        return false;
+    }
+
+    result = Value(Op()(std::get<L>(lhs.value), std::get<R>(rhs.value)));
+    return true;
+}
+
+// __add__ & co. and the comparisons, registered for every Integer/Float pair
+template <typename L, typename R>
+Kernel numeric(const int op) {
+    switch (op) {
+        case TPLUS:
+            return kernel<L, R, std::plus<>>;
+        case TMINUS:
+            return kernel<L, R, std::minus<>>;
+        case TMUL:
+            return kernel<L, R, std::multiplies<>>;
+        case TDIV:
+            return kernel<L, R, std::divides<>>;
+        case TEQ:
+            return kernel<L, R, std::equal_to<>>;
+        case TNE:
+            return kernel<L, R, std::not_equal_to<>>;
+        case TGTE:
+            return kernel<L, R, std::greater_equal<>>;
+        case TGT:
+            return kernel<L, R, std::greater<>>;
+        case TLTE:
+            return kernel<L, R, std::less_equal<>>;
+        case TLT:
+            return kernel<L, R, std::less<>>;
+        default:
+            return nullptr;
+    }
+}
+
+// __and__, __or__ and the comparisons, registered for two Booleans
+Kernel logical(const int op) {
+    switch (op) {
+        case TAND:
+            return kernel<bool, bool, std::logical_and<>>;
+        case TOR:
+            return kernel<bool, bool, std::logical_or<>>;
+        case TEQ:
+            return kernel<bool, bool, std::equal_to<>>;
+        case TNE:
+            return kernel<bool, bool, std::not_equal_to<>>;
+        case TGTE:
+            return kernel<bool, bool, std::greater_equal<>>;
+        case TGT:
+            return kernel<bool, bool, std::greater<>>;
+        case TLTE:
+            return kernel<bool, bool, std::less_equal<>>;
+        case TLT:
+            return kernel<bool, bool, std::less<>>;
+        default:
+            return nullptr;
+    }
+}
+
+// nullptr unless both operand types are known and the builtin takes them
+Kernel resolve(const int op, const Type lhs, const Type rhs) {
+    if (lhs == Type::Integer && rhs == Type::Integer) {
+        return numeric<long, long>(op);
+    }
+    else if (lhs == Type::Integer && rhs == Type::Float) {
+        return numeric<long, double>(op);
+    }
+    else if (lhs == Type::Float && rhs == Type::Integer) {
+        return numeric<double, long>(op);
+    }
+    else if (lhs == Type::Float && rhs == Type::Float) {
+        return numeric<double, double>(op);
+    }
+    else if (lhs == Type::Boolean && rhs == Type::Boolean) {
+        return logical(op);
+    }
+
+    return nullptr;
+}
+
+bool is_arithmetic(const int op) {
+    return op == TPLUS || op == TMINUS || op == TMUL || op == TDIV;
+}
+
+// the type both `a` and `b` fit in
+Type join(const Type a, const Type b) {
+    if (a == Type::Void) {
+        return b;
+    }
+    if (b == Type::Void || a == b) {
+        return a;
+    }
+
+    return Type::Any;
+}
+
+// what a parameter annotation guarantees on entry; only scalars matter here
+Type annotated(const std::string& name) {
+    if (name == "Integer") {
+        return Type::Integer;
+    }
+    else if (name == "Float") {
+        return Type::Float;
+    }
+    else if (name == "Boolean") {
+        return Type::Boolean;
+    }
+    else if (name == "String") {
+        return Type::String;
+    }
+
+    return Type::Any;
+}
+
+// every method name the program declares, at any depth
+void collect_declared(const Block* block, std::set<std::string>& declared) {
+    if (nullptr == block) {
+        return;
+    }
+
+    for (const auto statement: block->statements) {
+        if (const auto function = dynamic_cast<const Function*>(statement)) {
+            declared.insert(function->id.name);
+            collect_declared(function->block, declared);
+        }
+        else if (const auto if_statement = dynamic_cast<const IfStatement*>(statement)) {
+            collect_declared(if_statement->then_block, declared);
+            collect_declared(if_statement->else_block, declared);
+        }
+        else if (const auto for_loop = dynamic_cast<const ForLoop*>(statement)) {
+            collect_declared(for_loop->block, declared);
+        }
+        else if (const auto while_loop = dynamic_cast<const WhileLoop*>(statement)) {
+            collect_declared(while_loop->block, declared);
+        }
+    }
+}
+
+class Inference {
+public:
+    explicit Inference(const Block* program) {
+        collect_declared(program, declared);
+    }
+
+    // types the locals of one body, then specializes its operators
+    void body(Block* block, Scope& scope) {
+        while (assign(block, scope)) { }
+        annotate(block, scope);
+    }
+
+private:
+    std::set<std::string> declared;
+
+    // whether the program declares its own overloads of what `op` calls
+    bool overloaded(const int op) const {
+        const auto method = operator_method(op);
+        return nullptr == method || declared.count(method) > 0;
+    }
+
+    Type operator_type(const int op, const Expression& lhs, const Expression& rhs, const Scope& scope) const {
+        const auto lhs_type = type(lhs, scope);
+        const auto rhs_type = type(rhs, scope);
+
+        if (overloaded(op)) {
+            return Type::Any;
+        }
+        if (lhs_type == Type::Void || rhs_type == Type::Void) {
+            return Type::Void;
+        }
+        if (lhs_type == Type::String && rhs_type == Type::String) {
+            return op == TPLUS ? Type::String : ((op == TEQ || op == TNE) ? Type::Boolean : Type::Any);
+        }
+        if (nullptr == resolve(op, lhs_type, rhs_type)) {
+            return Type::Any;
+        }
+        if (!is_arithmetic(op)) {
+            return Type::Boolean;
+        }
+
+        return lhs_type == Type::Integer && rhs_type == Type::Integer ? Type::Integer : Type::Float;
+    }
+
+    Type type(const Expression& expression, const Scope& scope) const {
+        const auto expr_ptr = &expression;
+
+        if (nullptr != dynamic_cast<const Integer*>(expr_ptr)) {
+            return Type::Integer;
+        }
+        if (nullptr != dynamic_cast<const Float*>(expr_ptr)) {
+            return Type::Float;
+        }
+        if (nullptr != dynamic_cast<const Boolean*>(expr_ptr)) {
+            return Type::Boolean;
+        }
+        if (nullptr != dynamic_cast<const String*>(expr_ptr)) {
+            return Type::String;
+        }
+        if (nullptr != dynamic_cast<const VectorExpression*>(expr_ptr)) {
+            return Type::Vector;
+        }
+
+        if (const auto identifier = dynamic_cast<const Identifier*>(expr_ptr)) {
+            // not assigned in this body: whatever a caller's frame holds
+            const auto found = scope.find(identifier->name);
+            return found != scope.end() ? found->second : Type::Any;
+        }
+
+        if (const auto arithmetic = dynamic_cast<const ArithmeticExpression*>(expr_ptr)) {
+            return operator_type(arithmetic->op, arithmetic->lhs, arithmetic->rhs, scope);
+        }
+        if (const auto comparison = dynamic_cast<const ComparisonExpression*>(expr_ptr)) {
+            return operator_type(comparison->op, comparison->lhs, comparison->rhs, scope);
+        }
+        if (const auto binary = dynamic_cast<const BinaryExpression*>(expr_ptr)) {
+            return operator_type(binary->op, binary->lhs, binary->rhs, scope);
+        }
+
+        if (const auto negated = dynamic_cast<const NegatedBinaryExpression*>(expr_ptr)) {
+            const auto operand = type(negated->expr, scope);
+            if (declared.count("__not__") > 0) {
+                return Type::Any;
+            }
+
+            return (operand == Type::Boolean || operand == Type::Void) ? operand : Type::Any;
+        }
+
+        return Type::Any;
+    }
+
+    // what a for loop binds its variable to
+    Type element_type(const Expression& iterator, const Scope& scope) const {
+        const auto range = dynamic_cast<const RangeExpression*>(&iterator);
+        if (nullptr == range || declared.count("range") > 0) {
+            return Type::Any;
+        }
+
+        const auto start = type(range->start, scope);
+        const auto end = type(range->end, scope);
+        if (start == Type::Void || end == Type::Void) {
+            return Type::Void;
+        }
+
+        return start == Type::Integer && end == Type::Integer ? Type::Integer : Type::Any;
+    }
+
+    // one round over the assignments in `block`; true if a local's type changed
+    bool assign(const Block* block, Scope& scope) const {
+        if (nullptr == block) {
+            return false;
+        }
+
+        auto changed = false;
+        const auto bind = [&](const std::string& name, const Type type) {
+            // inserted as Void first, so `x = x + 1` doesn't read a caller's `x`
+            auto& current = scope[name];
+            const auto joined = join(current, type);
+            changed |= joined != current;
+            current = joined;
+        };
+
+        for (const auto statement: block->statements) {
+            if (const auto assignment = dynamic_cast<const Assignment*>(statement)) {
+                scope.emplace(assignment->id.name, Type::Void);
+                bind(assignment->id.name, type(assignment->expression, scope));
+            }
+            else if (const auto if_statement = dynamic_cast<const IfStatement*>(statement)) {
+                changed |= assign(if_statement->then_block, scope);
+                changed |= assign(if_statement->else_block, scope);
+            }
+            else if (const auto while_loop = dynamic_cast<const WhileLoop*>(statement)) {
+                changed |= assign(while_loop->block, scope);
+            }
+            else if (const auto parallel_loop = dynamic_cast<const ParallelForLoop*>(statement)) {
+                // chunks run below isolated frames, reductions merge whatever they built
+                bind(parallel_loop->id.name, Type::Any);
+                for (const auto reduction: parallel_loop->reductions) {
+                    bind(reduction->id.name, Type::Any);
+                }
+                changed |= assign(parallel_loop->block, scope);
+            }
+            else if (const auto for_loop = dynamic_cast<const ForLoop*>(statement)) {
+                scope.emplace(for_loop->id.name, Type::Void);
+                bind(for_loop->id.name, element_type(for_loop->iterator, scope));
+                changed |= assign(for_loop->block, scope);
+            }
+        }
+
+        return changed;
+    }
+
+    void annotate(Expression& expression, const Scope& scope) const {
+        const auto expr_ptr = &expression;
+
+        if (const auto arithmetic = dynamic_cast<ArithmeticExpression*>(expr_ptr)) {
+            annotate(arithmetic->lhs, scope);
+            annotate(arithmetic->rhs, scope);
+            if (!overloaded(arithmetic->op)) {
+                arithmetic->kernel = resolve(arithmetic->op, type(arithmetic->lhs, scope), type(arithmetic->rhs, scope));
+            }
+        }
+        else if (const auto comparison = dynamic_cast<ComparisonExpression*>(expr_ptr)) {
+            annotate(comparison->lhs, scope);
+            annotate(comparison->rhs, scope);
+            if (!overloaded(comparison->op)) {
+                comparison->kernel = resolve(comparison->op, type(comparison->lhs, scope), type(comparison->rhs, scope));
+            }
+        }
+        else if (const auto binary = dynamic_cast<BinaryExpression*>(expr_ptr)) {
+            annotate(binary->lhs, scope);
+            annotate(binary->rhs, scope);
+            if (!overloaded(binary->op)) {
+                binary->kernel = resolve(binary->op, type(binary->lhs, scope), type(binary->rhs, scope));
+            }
+        }
+        else if (const auto negated = dynamic_cast<NegatedBinaryExpression*>(expr_ptr)) {
+            annotate(negated->expr, scope);
+        }
+        else if (const auto call = dynamic_cast<FunctionCall*>(expr_ptr)) {
+            for (const auto argument: call->arguments) {
+                annotate(*argument, scope);
+            }
+        }
+        else if (const auto vector = dynamic_cast<VectorExpression*>(expr_ptr)) {
+            for (const auto argument: vector->arguments) {
+                annotate(*argument, scope);
+            }
+        }
+        else if (const auto range = dynamic_cast<RangeExpression*>(expr_ptr)) {
+            annotate(range->start, scope);
+            annotate(range->end, scope);
+        }
+        else if (const auto search = dynamic_cast<SearchExpression*>(expr_ptr)) {
+            annotate(search->collection, scope);
+            annotate(search->element, scope);
+        }
+        else if (const auto index = dynamic_cast<IndexExpression*>(expr_ptr)) {
+            annotate(index->identifier_expression, scope);
+            annotate(index->expression, scope);
+            if (nullptr != index->column_expression) {
+                annotate(*index->column_expression, scope);
+            }
+        }
+    }
+
+    void annotate(Block* block, const Scope& scope) {
+        if (nullptr == block) {
+            return;
+        }
+
+        for (const auto statement: block->statements) {
+            if (const auto assignment = dynamic_cast<Assignment*>(statement)) {
+                annotate(assignment->expression, scope);
+            }
+            else if (const auto expression_statement = dynamic_cast<ExpressionStatement*>(statement)) {
+                annotate(expression_statement->expression, scope);
+            }
+            else if (const auto yield_statement = dynamic_cast<YieldStatement*>(statement)) {
+                annotate(yield_statement->expression, scope);
+            }
+            else if (const auto if_statement = dynamic_cast<IfStatement*>(statement)) {
+                annotate(if_statement->condition, scope);
+                annotate(if_statement->then_block, scope);
+                annotate(if_statement->else_block, scope);
+            }
+            else if (const auto while_loop = dynamic_cast<WhileLoop*>(statement)) {
+                annotate(while_loop->condition, scope);
+                annotate(while_loop->block, scope);
+            }
+            else if (const auto for_loop = dynamic_cast<ForLoop*>(statement)) {
+                annotate(for_loop->iterator, scope);
+                annotate(for_loop->block, scope);
+            }
+            else if (const auto function = dynamic_cast<Function*>(statement)) {
+                // a body of its own: only its parameters are known on entry
+                auto locals = Scope();
+                for (const auto param: function->params) {
+                    locals[param->id.name] = annotated(param->type.name);
+                }
+                body(function->block, locals);
+            }
+        }
+    }
+};
+
+} // namespace
+
+const char* ELang::Runtime::operator_method(const int op) {
+    switch (op) {
+        case TPLUS:
+            return "__add__";
+        case TMINUS:
+            return "__sub__";
+        case TMUL:
+            return "__mul__";
+        case TDIV:
+            return "__div__";
+        case TAND:
+            return "__and__";
+        case TOR:
+            return "__or__";
+        case TEQ:
+            return "__eq__";
+        case TNE:
+            return "__ne__";
+        case TGTE:
+            return "__gte__";
+        case TGT:
+            return "__gt__";
+        case TLTE:
+            return "__lte__";
+        case TLT:
+            return "__lt__";
+        default:
+            return nullptr;
+    }
+}
+
+void ELang::Runtime::infer_types(Block* program) {
+    if (nullptr == program) {
+        return;
+    }
+
+    auto inference = Inference(program);
+    auto scope = Scope();
+    inference.body(program, scope);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "elang.hpp"
+
+namespace ELang {
+namespace Runtime {
+
+// Static type inference over a parsed program, run once when it is compiled.
+// Literals, parameter annotations and the operators themselves give types,
+// which flow into the locals a body assigns: a local only ever assigned one
+// type has that type everywhere in the body, one assigned two types is
+// unknown. Operators whose operand types are known get the Kernel of the
+// builtin they would resolve to, so eval_expression skips the lookup of
+// `__add__` & co. by name.
+//
+// Scoping is dynamic, so a callee or the host can still rebind a variable
+// behind the body's back: kernels check the operand tags they were resolved
+// for and decline, sending the operator through the overload search, when
+// they differ. Operators the program declares overloads of are left alone.
+void infer_types(Meta::Block* program);
+
+// the builtin an operator token calls, `__add__` for TPLUS; nullptr for
+// tokens that are not binary operators
+const char* operator_method(const int op);
+
+} // namespace Runtime
+} // namespace ELang
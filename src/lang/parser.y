@@ -1,11 +1,26 @@
 %{
 #include "../elang.hpp"
+%}
 
-ELang::Meta::Block *main_block;
+%code requires {
+typedef void* yyscan_t;
+}
 
-extern int yylex();
-void yyerror(const char *s) { printf("ERROR: %s", s); }
-%}
+%code {
+int yylex(YYSTYPE* lvalp, YYLTYPE* llocp, yyscan_t scanner);
+void yyerror(YYLTYPE* llocp, yyscan_t scanner, ELang::Meta::Block** program, const char *s) { std::cout << "ERROR: line " << llocp->first_line << ": " << s; }
+
+template <typename T>
+T* at(const YYLTYPE& location, T* statement) {
+    statement->line = location.first_line;
+    return statement;
+}
+}
+
+%define api.pure full
+%locations
+%lex-param { yyscan_t scanner }
+%parse-param { yyscan_t scanner } { ELang::Meta::Block** program }
 
 %union {
     ELang::Meta::Node* node;
@@ -16,12 +31,14 @@ void yyerror(const char *s) { printf("ERROR: %s", s); }
     ELang::Meta::TypedIdentifier* typed_identifier;
     std::vector<ELang::Meta::Expression*>* expressions;
     std::vector<ELang::Meta::TypedIdentifier*>* typed_identifiers;
-    std::string* string;
+    ELang::Meta::Reduction* reduction;
+    std::vector<ELang::Meta::Reduction*>* reductions;
+    ELang::Meta::Lexeme lexeme;
     int token;
 }
 
-%token <string> TIDENTIFIER TINTEGER TFLOAT TTRUE TFALSE TSTRING
-%token <string> TIF TELSE TFOR TWHILE TFUNCTION TEND
+%token <lexeme> TIDENTIFIER TINTEGER TFLOAT TTRUE TFALSE TSTRING
+%token <token> TIF TELSE TFOR TPARALLEL TWITH TWHILE TFUNCTION TYIELD TEND
 %token <token> TLPAREN TRPAREN TLBRACKET TRBRACKET TCOMMA TASSIGN TCOLON TDOUBLECOLON TIN
 
 %type <identifier> identifier
@@ -29,6 +46,8 @@ void yyerror(const char *s) { printf("ERROR: %s", s); }
 %type <expressions> arguments
 %type <typed_identifier> typed
 %type <typed_identifiers> params
+%type <reduction> reduction
+%type <reductions> reductions
 %type <block> program statements
 %type <statement> statement if_stmt loop func
 %type <token> arithmetic binary comparison
@@ -45,7 +64,7 @@ void yyerror(const char *s) { printf("ERROR: %s", s); }
 
 %%
 
-program    : statements { main_block = $1; }
+program    : statements { *program = $1; }
            ;
 
 statements : { $$ = new ELang::Meta::Block(); }
@@ -53,39 +72,50 @@ statements : { $$ = new ELang::Meta::Block(); }
            | statements statement { $1->statements.push_back($<statement>2); }
            ;
 
-statement  : expression { $$ = new ELang::Meta::ExpressionStatement(*$1); }
-           | identifier TASSIGN expression { $$ = new ELang::Meta::Assignment(*$1, *$3); }
+statement  : expression { $$ = at(@$, new ELang::Meta::ExpressionStatement(*$1)); }
+           | identifier TASSIGN expression { $$ = at(@$, new ELang::Meta::Assignment(*$1, *$3)); }
+           | TYIELD expression { $$ = at(@$, new ELang::Meta::YieldStatement(*$2)); }
            | if_stmt
            | loop
            | func
            ;
 
-if_stmt    : TIF expression statements TEND { $$ = new ELang::Meta::IfStatement(*$2, $3); }
-           | TIF expression statements TELSE statements TEND {$$ = new ELang::Meta::IfStatement(*$2, $3, $5); }
+if_stmt    : TIF expression statements TEND { $$ = at(@$, new ELang::Meta::IfStatement(*$2, $3)); }
+           | TIF expression statements TELSE statements TEND {$$ = at(@$, new ELang::Meta::IfStatement(*$2, $3, $5)); }
+           ;
+
+loop       : TFOR identifier TIN expression statements TEND { $$ = at(@$, new ELang::Meta::ForLoop(*$2, *$4, $5)); }
+           | TPARALLEL TFOR identifier TIN expression statements TEND { $$ = at(@$, new ELang::Meta::ParallelForLoop(*$3, *$5, *(new std::vector<ELang::Meta::Reduction*>()), $6)); }
+           | TPARALLEL TFOR identifier TIN expression TWITH reductions statements TEND { $$ = at(@$, new ELang::Meta::ParallelForLoop(*$3, *$5, *$7, $8)); }
+           | TWHILE expression statements TEND { $$ = at(@$, new ELang::Meta::WhileLoop(*$2, $3)); }
+           ;
+
+reductions : reduction { $$ = new std::vector<ELang::Meta::Reduction*>(); $$->push_back($1); }
+           | reductions TCOMMA reduction { $1->push_back($3); }
            ;
 
-loop       : TFOR identifier TIN expression statements TEND { $$ = new ELang::Meta::ForLoop(*$2, *$4, $5); }
-           | TWHILE expression statements TEND { $$ = new ELang::Meta::WhileLoop(*$2, $3); }
+reduction  : identifier TLPAREN identifier TRPAREN { $$ = new ELang::Meta::Reduction(*$1, *$3); }
            ;
 
-func       : TFUNCTION identifier TLPAREN params TRPAREN statements TEND { $$ = new ELang::Meta::Function(*$2, *$4, $6); }
+func       : TFUNCTION identifier TLPAREN params TRPAREN statements TEND { $$ = at(@$, new ELang::Meta::Function(*$2, *$4, $6)); }
            ;
 
-identifier : TIDENTIFIER { $$ = new ELang::Meta::Identifier(*$1); delete $1; }
+identifier : TIDENTIFIER { $$ = new ELang::Meta::Identifier($1.view()); }
            ;
 
-number     : TINTEGER { $$ = new ELang::Meta::Integer(atol($1->c_str())); delete $1; }
-           | TFLOAT { $$ = new ELang::Meta::Float(atof($1->c_str())); delete $1; }
+number     : TINTEGER { auto value = 0L; if (!$1.to_integer(value)) { yyerror(&@1, scanner, program, "integer literal out of range"); YYERROR; } $$ = new ELang::Meta::Integer(value); }
+           | TFLOAT { auto value = 0.0; if (!$1.to_float(value)) { yyerror(&@1, scanner, program, "float literal out of range"); YYERROR; } $$ = new ELang::Meta::Float(value); }
            ;
 
-boolean    : TTRUE { $$ = new ELang::Meta::Boolean(true); delete $1; }
-           | TFALSE { $$ = new ELang::Meta::Boolean(false); delete $1; }
+boolean    : TTRUE { $$ = new ELang::Meta::Boolean(true); }
+           | TFALSE { $$ = new ELang::Meta::Boolean(false); }
            ;
 
-string     : TSTRING { $$ = new ELang::Meta::String(*$1); delete $1; }
+string     : TSTRING { $$ = new ELang::Meta::String($1.view()); }
 
 expression : identifier TLPAREN arguments TRPAREN { $$ = new ELang::Meta::FunctionCall(*$1, *$3); delete $3; }
            | identifier TLBRACKET expression TRBRACKET { $$ = new ELang::Meta::IndexExpression(*$1, *$3); }
+           | identifier TLBRACKET expression TCOMMA expression TRBRACKET { $$ = new ELang::Meta::IndexExpression(*$1, *$3, $5); }
            | number| boolean | string | identifier
            | expression arithmetic expression { $$ = new ELang::Meta::ArithmeticExpression(*$1, $2, *$3); }
            | expression comparison expression { $$ = new ELang::Meta::ComparisonExpression(*$1, $2, *$3); }
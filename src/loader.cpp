@@ -0,0 +1,273 @@
+#include "loader.hpp"
+#include "pool.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+
+using namespace ELang::Runtime;
+
+namespace {
+
+// chunks smaller than this aren't worth a pool task
+constexpr std::size_t min_chunk = 64 * 1024;
+
+class Chunk {
+public:
+    std::string_view text;
+    std::vector<std::vector<Value>> columns;
+    std::size_t lines = 0; // line breaks consumed, up to the error if any
+    bool failed = false;
+    std::string message;
+};
+
+bool parse_number(const char* first, const char* last, Value& value) {
+    auto integer = 0L;
+    const auto as_integer = std::from_chars(first, last, integer);
+    if (as_integer.ec == std::errc() && as_integer.ptr == last) {
+        value = Value(integer);
+        return true;
+    }
+
+    auto real = 0.0;
+    const auto as_real = std::from_chars(first, last, real);
+    if (as_real.ec == std::errc() && as_real.ptr == last) {
+        value = Value(real);
+        return true;
+    }
+
+    return false;
+}
+
+// cut `text` after line breaks into about one piece per `min_chunk`, a few
+// per pool thread at most so uneven pieces even out
+std::vector<Chunk> split_lines(const std::string_view text, const std::size_t column_count) {
+    const auto parts = std::max<std::size_t>(1, std::min(ThreadPool::instance().size() * 4, text.size() / min_chunk));
+    auto chunks = std::vector<Chunk>();
+    auto begin = std::size_t(0);
+
+    for (std::size_t i = 1; i <= parts && begin < text.size(); ++i) {
+        auto end = text.size();
+        if (i < parts) {
+            const auto newline = text.find('\n', std::max(begin, text.size() * i / parts));
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+
+        chunks.emplace_back();
+        chunks.back().text = text.substr(begin, end - begin);
+        chunks.back().columns.resize(column_count);
+        begin = end;
+    }
+
+    return chunks;
+}
+
+template<typename Parse>
+void parse_chunks(std::vector<Chunk>& chunks, const Parse& parse) {
+    ThreadPool::instance().run(chunks.size(), [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            parse(chunks[i]);
+        }
+    }, 1);
+}
+
+// the first failing chunk, in text order, with its line made absolute
+bool check_chunks(const std::vector<Chunk>& chunks, const std::size_t first_line, LoadError& error) {
+    auto line = first_line;
+
+    for (const auto& chunk: chunks) {
+        if (chunk.failed) {
+            error.line = line + chunk.lines;
+            error.message = chunk.message;
+            return false;
+        }
+
+        line += chunk.lines;
+    }
+
+    return true;
+}
+
+// move every chunk's piece of column `column` into `result`, in parallel
+void gather(std::vector<Chunk>& chunks, const std::size_t column, std::vector<Value>& result) {
+    if (chunks.size() == 1) {
+        result.swap(chunks[0].columns[column]);
+        return;
+    }
+
+    auto offsets = std::vector<std::size_t>(chunks.size() + 1, 0);
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        offsets[i + 1] = offsets[i] + chunks[i].columns[column].size();
+    }
+
+    result.resize(offsets.back());
+    ThreadPool::instance().run(chunks.size(), [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            auto& piece = chunks[i].columns[column];
+            std::move(piece.begin(), piece.end(), result.begin() + offsets[i]);
+            piece = std::vector<Value>();
+        }
+    }, 1);
+}
+
+inline bool is_space(const char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+void fail(Chunk& chunk, const char* first, const char* last) {
+    chunk.failed = true;
+    chunk.message = "invalid number `" + std::string(first, last) + "`";
+}
+
+// the fields of one line, without the line break (and a '\r' before it)
+template<typename Field>
+std::size_t split_fields(const char* first, const char* last, const char separator, const Field& field) {
+    if (first != last && *(last - 1) == '\r') {
+        --last;
+    }
+
+    auto count = std::size_t(0);
+    for (;;) {
+        const auto end = std::find(first, last, separator);
+
+        // surrounding blanks are not part of the number
+        auto field_first = first;
+        auto field_last = end;
+        while (field_first != field_last && (*field_first == ' ' || *field_first == '\t')) {
+            ++field_first;
+        }
+        while (field_last != field_first && (*(field_last - 1) == ' ' || *(field_last - 1) == '\t')) {
+            --field_last;
+        }
+
+        if (!field(count++, field_first, field_last)) {
+            return count;
+        }
+
+        if (end == last) {
+            return count;
+        }
+        first = end + 1;
+    }
+}
+
+} // namespace
+
+bool ELang::Runtime::load_numbers(const std::string_view text, std::vector<Value>& numbers, LoadError& error) {
+    auto chunks = split_lines(text, 1);
+
+    parse_chunks(chunks, [](Chunk& chunk) {
+        auto& values = chunk.columns[0];
+        values.reserve(chunk.text.size() / 8);
+
+        auto position = chunk.text.data();
+        const auto last = position + chunk.text.size();
+        auto value = Value();
+
+        while (position != last) {
+            if (is_space(*position) || *position == ',') {
+                chunk.lines += *position == '\n';
+                ++position;
+                continue;
+            }
+
+            const auto token = position;
+            while (position != last && !is_space(*position) && *position != ',') {
+                ++position;
+            }
+
+            if (!parse_number(token, position, value)) {
+                fail(chunk, token, position);
+                return;
+            }
+            values.push_back(value);
+        }
+    });
+
+    if (!check_chunks(chunks, 1, error)) {
+        return false;
+    }
+
+    gather(chunks, 0, numbers);
+    return true;
+}
+
+bool ELang::Runtime::load_csv(const std::string_view text, const char separator,
+                              std::vector<std::shared_ptr<std::vector<Value>>>& columns, LoadError& error) {
+    // the first line fixes the column count and may be a header
+    auto first_line = text.substr(0, text.find('\n'));
+    auto data = text.substr(std::min(text.size(), first_line.size() + 1));
+    auto line = std::size_t(1);
+    auto parsed = std::size_t(0);
+    auto value = Value();
+
+    const auto column_count = split_fields(first_line.data(), first_line.data() + first_line.size(), separator,
+        [&](std::size_t, const char* first, const char* last) {
+            parsed += parse_number(first, last, value) ? 1 : 0;
+            return true;
+        });
+
+    // only a line of names is a header: a row with a bad field is reported below
+    if (parsed == 0) {
+        ++line;
+    }
+    else {
+        data = text;
+    }
+
+    auto chunks = split_lines(data, column_count);
+    parse_chunks(chunks, [separator, column_count](Chunk& chunk) {
+        for (auto& column: chunk.columns) {
+            column.reserve(chunk.text.size() / (8 * column_count));
+        }
+
+        auto position = chunk.text.data();
+        const auto last = position + chunk.text.size();
+        auto value = Value();
+
+        while (position != last) {
+            const auto line_end = std::find(position, last, '\n');
+
+            // blank lines, e.g. the one a trailing line break leaves, hold no row
+            if (std::any_of(position, line_end, [](const char c) { return !is_space(c); })) {
+                const auto fields = split_fields(position, line_end, separator, [&](std::size_t index, const char* field_first, const char* field_last) {
+                    // extra fields are only counted, for the error below
+                    if (index >= column_count) {
+                        return true;
+                    }
+                    if (!parse_number(field_first, field_last, value)) {
+                        fail(chunk, field_first, field_last);
+                        return false;
+                    }
+
+                    chunk.columns[index].push_back(value);
+                    return true;
+                });
+
+                if (chunk.failed) {
+                    return;
+                }
+                if (fields != column_count) {
+                    chunk.failed = true;
+                    chunk.message = "expected " + std::to_string(column_count) + " fields, found " + std::to_string(fields);
+                    return;
+                }
+            }
+
+            position = line_end == last ? last : line_end + 1;
+            ++chunk.lines;
+        }
+    });
+
+    if (!check_chunks(chunks, line, error)) {
+        return false;
+    }
+
+    columns.clear();
+    for (std::size_t i = 0; i < column_count; ++i) {
+        columns.push_back(std::make_shared<std::vector<Value>>());
+        gather(chunks, i, *columns.back());
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "vm.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ELang {
+namespace Runtime {
+
+// Turns numeric text into vectors on the thread pool: the text is cut at line
+// breaks into chunks, each parsed with std::from_chars into a vector of its
+// own, and the pieces are moved into place once every chunk is done. Numbers
+// that parse as a whole `long` become Integers, the rest Floats.
+class LoadError {
+public:
+    std::size_t line;
+    std::string message;
+};
+
+// every number in `text`, separated by whitespace or commas
+bool load_numbers(const std::string_view text, std::vector<Value>& numbers, LoadError& error);
+
+// one vector per column. A first line where no field parses is taken as a
+// header and skipped; one where only some do is data, and its bad fields are
+// errors. Every other line needs as many fields as the first one.
+bool load_csv(const std::string_view text, const char separator,
+              std::vector<std::shared_ptr<std::vector<Value>>>& columns, LoadError& error);
+
+} // namespace Runtime
+} // namespace ELang
@@ -1,23 +1,158 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
-#include "elang.hpp"
-#include "vm.hpp"
+#include <iterator>
+#include <string>
+#include "elc.hpp"
+#include "file.hpp"
+#include "memory.hpp"
+#include "output.hpp"
+#include "profile.hpp"
+#include "server.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 
-using namespace ELang::Meta;
-using namespace ELang::Runtime;
+using namespace ELang;
 using namespace std;
 
-extern Block* main_block;
-extern int yyparse();
+namespace {
+
+class Options {
+public:
+    bool profile = false;
+    bool stats = false;
+    bool memory = false;
+
+    // --trace: where the trace goes, empty when not tracing
+    string trace;
+    bool trace_builtins = false;
+    long trace_threshold_us = 0;
+};
+
+// reports go to stderr after whatever the script printed, the collapsed
+// stacks next to the script
+void report(const Options& options, const string& script) {
+    if (options.profile) {
+        Runtime::Profile::stop();
+    }
+    cout.flush();
+
+    if (options.stats) {
+        Runtime::Stats::write_report(cerr);
+    }
+    if (options.memory) {
+        Runtime::Memory::write_report(cerr, script);
+    }
+    if (!options.trace.empty()) {
+        if (Runtime::Trace::write(options.trace)) {
+            cerr << "Trace written to " << options.trace << endl;
+        }
+        else {
+            cerr << "Error: " << options.trace << ": " << strerror(errno) << endl;
+        }
+    }
+
+    if (!options.profile) {
+        return;
+    }
+
+    Runtime::Profile::write_report(cerr, script);
+
+    const auto folded = script + ".folded";
+    ofstream out(folded, ios::trunc);
+    Runtime::Profile::write_collapsed(out);
+    if (out.flush()) {
+        cerr << "Collapsed stacks written to " << folded << endl;
+    }
+}
+
+} // namespace
 
 int main(int argc, char **argv) {
-    cout << "E Language Compiler v0.1p0" << endl << endl;
+    Runtime::install_output();
+
+    cout << "E Language Compiler v" << version << endl << endl;
+
+    if (argc == 3 && string(argv[1]) == "--serve") {
+        return serve(argv[2]);
+    }
+
+    auto options = Options();
+    auto arg = 1;
+    for (; arg < argc && string(argv[arg]).rfind("--", 0) == 0; ++arg) {
+        const auto option = string(argv[arg]);
+        if (option == "--profile") {
+            options.profile = true;
+        }
+        else if (option == "--stats") {
+            options.stats = true;
+        }
+        else if (option == "--mem-report") {
+            options.memory = true;
+        }
+        else if (option == "--trace" && arg + 1 < argc) {
+            options.trace = argv[++arg];
+        }
+        else if (option == "--trace-builtins") {
+            options.trace_builtins = true;
+        }
+        else if (option == "--trace-threshold" && arg + 1 < argc) {
+            // microseconds, shorter calls are not recorded
+            options.trace_threshold_us = atol(argv[++arg]);
+        }
+        else {
+            cerr << "Error: Unknown option `" << option << "`" << endl;
+            return 1;
+        }
+    }
+
+    const auto script = arg < argc ? string(argv[arg]) : string("stdin");
+
+    // before compiling, so the AST is accounted for too
+    if (options.memory) {
+        Runtime::Memory::start();
+    }
+
+    auto program = shared_ptr<const Program>();
+    if (arg < argc) {
+        program = Program::compile_file(script);
+    }
+    else {
+        const auto source = string(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+        program = Program::compile(source);
+    }
+
+    if (nullptr == program) {
+        return 1;
+    }
+
+    if (options.profile) {
+        Runtime::Profile::start();
+    }
+    if (options.stats) {
+        Runtime::Stats::start();
+    }
+    if (!options.trace.empty()) {
+        Runtime::Trace::start(chrono::microseconds(options.trace_threshold_us), options.trace_builtins);
+    }
 
-    yyparse();
+    Engine engine;
+    try {
+        engine.run(*program);
+    }
+    catch (...) {
+        // a failing script is often the one worth measuring
+        report(options, script);
 
-    Interpreter runtime;
-    runtime.register_builtins();
+        // what it wrote before failing is kept, as if it had closed its files
+        Runtime::File::close_all();
+        throw;
+    }
 
-    runtime.run(main_block, runtime.global_context);
+    report(options, script);
 
     return 0;
-}
\ No newline at end of file
+}
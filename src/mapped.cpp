@@ -0,0 +1,48 @@
+#include "mapped.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ELang::Runtime;
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, const std::size_t padding) {
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    const auto size = static_cast<std::size_t>(info.st_size);
+    const auto mapped = size + padding;
+
+    // reserve the padded range as zero pages, then lay the file over its start;
+    // the tail of the file's last page is zero-filled by the kernel
+    auto data = mmap(nullptr, mapped == 0 ? 1 : mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED != data && size > 0) {
+        if (MAP_FAILED == mmap(data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0)) {
+            munmap(data, mapped);
+            data = MAP_FAILED;
+        }
+        else {
+            madvise(data, size, MADV_SEQUENTIAL);
+        }
+    }
+
+    close(fd);
+    if (MAP_FAILED == data) {
+        return nullptr;
+    }
+
+    return std::shared_ptr<MappedFile>(new MappedFile(static_cast<char*>(data), size, mapped == 0 ? 1 : mapped));
+}
+
+MappedFile::~MappedFile() {
+    munmap(data, mapped);
+}
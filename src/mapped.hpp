@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace ELang {
+namespace Runtime {
+
+// A whole file mapped into memory, copy-on-write: writes through `data` stay
+// private to the process. `padding` zero bytes follow the contents (pages
+// past the end of the file are anonymous), e.g. the two NULs the in-place
+// lexer needs.
+class MappedFile {
+public:
+    char* data;
+    std::size_t size;
+
+    // nullptr if the file can't be opened or mapped, with errno set
+    static std::shared_ptr<MappedFile> open(const std::string& path, const std::size_t padding = 0);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+    std::size_t mapped;
+
+    MappedFile(char* data, const std::size_t size, const std::size_t mapped):
+        data(data), size(size), mapped(mapped) { }
+};
+
+} // namespace Runtime
+} // namespace ELang
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ELang {
+namespace Runtime {
+
+// Packed Booleans, one bit per element. Bits past `length` in the last word
+// are kept at zero so whole-word kernels (popcount, not) stay exact.
+class Mask {
+public:
+    std::size_t length;
+    std::vector<std::uint64_t> words;
+
+    Mask(const std::size_t length): length(length), words((length + 63) / 64, 0) { }
+
+    inline bool get(const std::size_t index) const { return (words[index >> 6] >> (index & 63)) & 1; }
+    inline void set(const std::size_t index) { words[index >> 6] |= std::uint64_t(1) << (index & 63); }
+
+    inline void trim() {
+        if (length % 64 != 0) {
+            words.back() &= (std::uint64_t(1) << (length % 64)) - 1;
+        }
+    }
+};
+
+} // namespace Runtime
+} // namespace ELang
@@ -0,0 +1,114 @@
+#include "matrix.hpp"
+#include "pool.hpp"
+
+#include <algorithm>
+
+using namespace ELang::Runtime;
+
+namespace {
+
+// 64x64 doubles = 32KB per tile, so one tile of each operand stays in L2
+const std::size_t block = 64;
+
+// below this many multiply-adds the pool is not worth waking up
+const std::size_t parallel_work = 1 << 20;
+
+// transpose tiles are smaller: reads and writes walk different directions
+const std::size_t transpose_block = 32;
+
+} // namespace
+
+void ELang::Runtime::matmul(const Matrix& lhs, const Matrix& rhs, Matrix& result) {
+    const auto n = lhs.rows;
+    const auto k = lhs.cols;
+    const auto m = rhs.cols;
+
+    std::fill(result.data.begin(), result.data.end(), 0.0);
+
+    const auto multiply_rows = [&](std::size_t begin, std::size_t end) {
+        for (auto rb = begin; rb < end; ++rb) {
+            const auto i0 = rb * block;
+            const auto i1 = std::min(i0 + block, n);
+
+            for (std::size_t p0 = 0; p0 < k; p0 += block) {
+                const auto p1 = std::min(p0 + block, k);
+
+                for (std::size_t j0 = 0; j0 < m; j0 += block) {
+                    const auto j1 = std::min(j0 + block, m);
+
+                    // i-p-j order keeps the innermost loop contiguous in both
+                    // `rhs` and `result`, so it vectorizes
+                    for (auto i = i0; i < i1; ++i) {
+                        double* out = result.data.data() + i * m;
+
+                        for (auto p = p0; p < p1; ++p) {
+                            const auto a = lhs.data[i * k + p];
+                            const double* row = rhs.data.data() + p * m;
+
+                            for (auto j = j0; j < j1; ++j) {
+                                out[j] += a * row[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    // row blocks are independent, large products hand them out to the pool
+    const auto row_blocks = (n + block - 1) / block;
+    if (n * k * m < parallel_work) {
+        multiply_rows(0, row_blocks);
+    }
+    else {
+        ThreadPool::instance().run(row_blocks, multiply_rows, 1);
+    }
+}
+
+void ELang::Runtime::transpose(const Matrix& source, Matrix& result) {
+    for (std::size_t i0 = 0; i0 < source.rows; i0 += transpose_block) {
+        const auto i1 = std::min(i0 + transpose_block, source.rows);
+
+        for (std::size_t j0 = 0; j0 < source.cols; j0 += transpose_block) {
+            const auto j1 = std::min(j0 + transpose_block, source.cols);
+
+            for (auto i = i0; i < i1; ++i) {
+                for (auto j = j0; j < j1; ++j) {
+                    result.data[j * source.rows + i] = source.data[i * source.cols + j];
+                }
+            }
+        }
+    }
+}
+
+std::vector<double> ELang::Runtime::row_sums(const Matrix& source) {
+    auto sums = std::vector<double>(source.rows, 0.0);
+
+    for (std::size_t i = 0; i < source.rows; ++i) {
+        const double* row = source.data.data() + i * source.cols;
+        auto acc = 0.0;
+
+        for (std::size_t j = 0; j < source.cols; ++j) {
+            acc += row[j];
+        }
+
+        sums[i] = acc;
+    }
+
+    return sums;
+}
+
+std::vector<double> ELang::Runtime::col_sums(const Matrix& source) {
+    auto sums = std::vector<double>(source.cols, 0.0);
+
+    // walk row by row and accumulate into all columns at once
+    for (std::size_t i = 0; i < source.rows; ++i) {
+        const double* row = source.data.data() + i * source.cols;
+
+        for (std::size_t j = 0; j < source.cols; ++j) {
+            sums[j] += row[j];
+        }
+    }
+
+    return sums;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace ELang {
+namespace Runtime {
+
+// Dense matrix of Floats, stored row-major in a single contiguous block.
+class Matrix {
+public:
+    std::size_t rows;
+    std::size_t cols;
+    std::vector<double> data;
+
+    Matrix(const std::size_t rows, const std::size_t cols, const double fill = 0.0):
+        rows(rows), cols(cols), data(rows * cols, fill) { }
+
+    inline double& at(const std::size_t row, const std::size_t col) { return data[row * cols + col]; }
+    inline double at(const std::size_t row, const std::size_t col) const { return data[row * cols + col]; }
+};
+
+// `result` must already have the right shape
+void matmul(const Matrix& lhs, const Matrix& rhs, Matrix& result);
+void transpose(const Matrix& source, Matrix& result);
+
+std::vector<double> row_sums(const Matrix& source);
+std::vector<double> col_sums(const Matrix& source);
+
+} // namespace Runtime
+} // namespace ELang
@@ -0,0 +1,198 @@
+#include "memory.hpp"
+#include "elang.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace ELang;
+using namespace ELang::Runtime;
+
+std::atomic<bool> Memory::enabled(false);
+
+namespace {
+
+constexpr std::size_t category_count = static_cast<std::size_t>(Memory::Category::Count);
+
+class Account {
+public:
+    std::atomic<std::int64_t> live;
+    std::atomic<std::int64_t> peak;
+};
+
+// zero-initialised statics, usable before any constructor runs
+Account accounts[category_count];
+Account overall;
+
+void raise(Account& account, const std::int64_t bytes) {
+    const auto live = account.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    auto peak = account.peak.load(std::memory_order_relaxed);
+    while (live > peak && !account.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+}
+
+class Site {
+public:
+    std::uint64_t bytes = 0;
+    std::uint64_t count = 0;
+};
+
+// Per thread, so allocating never contends; the mutex is only ever taken by
+// the owner and, once, by the report.
+class Sites {
+public:
+    std::mutex mutex;
+    std::unordered_map<int, Site> lines;
+};
+
+std::mutex registry_mutex;
+std::vector<Sites*> registry;
+
+thread_local Sites* local = nullptr;
+thread_local int current_line = 0;
+
+Sites& sites() {
+    if (nullptr == local) {
+        // kept until exit, the report may run after the thread is gone
+        local = new Sites();
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(local);
+    }
+
+    return *local;
+}
+
+std::string format_bytes(const std::int64_t bytes) {
+    static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+
+    auto value = static_cast<double>(bytes);
+    auto unit = std::size_t(0);
+    while (std::abs(value) >= 1024.0 && unit + 1 < sizeof(units) / sizeof(units[0])) {
+        value /= 1024.0;
+        ++unit;
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << value << " " << units[unit];
+    return out.str();
+}
+
+} // namespace
+
+void Memory::charge(const Category category, const std::size_t bytes) {
+    raise(accounts[static_cast<std::size_t>(category)], bytes);
+    raise(overall, bytes);
+
+    // nodes are built while parsing, before any line runs
+    if (category == Category::Ast) {
+        return;
+    }
+
+    auto& mine = sites();
+    std::lock_guard<std::mutex> lock(mine.mutex);
+    auto& site = mine.lines[current_line];
+    site.bytes += bytes;
+    ++site.count;
+}
+
+void Memory::release(const Category category, const std::size_t bytes) {
+    accounts[static_cast<std::size_t>(category)].live.fetch_sub(bytes, std::memory_order_relaxed);
+    overall.live.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void Memory::line(const int line) {
+    current_line = line;
+}
+
+const char* Memory::name(const Category category) {
+    switch (category) {
+        case Category::Vector:
+            return "Vector";
+        case Category::String:
+            return "String";
+        case Category::Context:
+            return "Context";
+        case Category::Ast:
+            return "Ast";
+        default:
+            return "";
+    }
+}
+
+Memory::Usage Memory::usage(const Category category) {
+    const auto& account = accounts[static_cast<std::size_t>(category)];
+    return Usage{account.live.load(std::memory_order_relaxed), account.peak.load(std::memory_order_relaxed)};
+}
+
+Memory::Usage Memory::total() {
+    return Usage{overall.live.load(std::memory_order_relaxed), overall.peak.load(std::memory_order_relaxed)};
+}
+
+void Memory::start() {
+    enabled.store(true);
+}
+
+void Memory::write_report(std::ostream& out, const std::string& script) {
+    out << "Memory           live        peak" << std::endl;
+    for (std::size_t i = 0; i < category_count; ++i) {
+        const auto category = static_cast<Category>(i);
+        const auto current = usage(category);
+
+        out << "  " << std::left << std::setw(9) << name(category) << std::right
+            << std::setw(12) << format_bytes(current.live) << std::setw(12) << format_bytes(current.peak) << std::endl;
+    }
+    const auto all = total();
+    out << "  " << std::left << std::setw(9) << "total" << std::right
+        << std::setw(12) << format_bytes(all.live) << std::setw(12) << format_bytes(all.peak) << std::endl;
+
+    auto lines = std::unordered_map<int, Site>();
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto thread: registry) {
+            std::lock_guard<std::mutex> thread_lock(thread->mutex);
+            for (const auto& line: thread->lines) {
+                lines[line.first].bytes += line.second.bytes;
+                lines[line.first].count += line.second.count;
+            }
+        }
+    }
+
+    auto top = std::vector<std::pair<int, Site>>(lines.cbegin(), lines.cend());
+    std::sort(top.begin(), top.end(), [](const auto& a, const auto& b) { return a.second.bytes > b.second.bytes; });
+    top.resize(std::min<std::size_t>(top.size(), 10));
+
+    out << std::endl << "Most allocated by line:" << std::endl;
+    for (const auto& line: top) {
+        out << std::setw(12) << format_bytes(line.second.bytes) << std::setw(12) << line.second.count << "  ";
+        if (line.first > 0) {
+            out << script << ":" << line.first << std::endl;
+        }
+        else {
+            out << "(setup)" << std::endl;
+        }
+    }
+}
+
+void* Meta::Node::operator new(const std::size_t size) {
+    const auto node = ::operator new(size);
+    if (Memory::active()) {
+        Memory::charge(Memory::Category::Ast, size);
+    }
+
+    return node;
+}
+
+void Meta::Node::operator delete(void* node, const std::size_t size) {
+    if (Memory::active()) {
+        Memory::release(Memory::Category::Ast, size);
+    }
+
+    ::operator delete(node);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace ELang {
+namespace Runtime {
+namespace Memory {
+
+// Memory accounting behind `elc --mem-report` and `memstats()`. Payloads
+// carry a Charge for the bytes they hold: vector and string storage, Context
+// frames with their variables, AST nodes. Charges are taken where a payload
+// is created and adjusted when it grows or is copied out, so storage kept
+// alive only by slices into it counts as freed with the slice that made it.
+// Off unless started; a Charge then costs a flag check.
+
+enum class Category: std::uint8_t {
+    Vector,
+    String,
+    Context,
+    Ast,
+    Count,
+};
+
+extern std::atomic<bool> enabled;
+
+inline bool active() { return enabled.load(std::memory_order_relaxed); }
+
+void charge(const Category category, const std::size_t bytes);
+void release(const Category category, const std::size_t bytes);
+
+// the script line allocations on this thread are attributed to
+void line(const int line);
+
+class Charge {
+public:
+    explicit Charge(const Category category): category(category), bytes(0) { }
+    Charge(const Category category, const std::size_t bytes): category(category), bytes(0) { resize(bytes); }
+
+    // a copy holds nothing until it resizes: the bytes stay with the original
+    Charge(const Charge& other): category(other.category), bytes(0) { }
+    Charge& operator=(const Charge&) { return *this; }
+
+    ~Charge() {
+        if (bytes > 0) {
+            release(category, bytes);
+        }
+    }
+
+    inline void resize(const std::size_t size) {
+        if (!active() || size == bytes) {
+            return;
+        }
+
+        if (size > bytes) {
+            charge(category, size - bytes);
+        }
+        else {
+            release(category, bytes - size);
+        }
+        bytes = size;
+    }
+
+    inline void grow(const std::size_t size) { resize(bytes + size); }
+
+private:
+    Category category;
+    std::size_t bytes;
+};
+
+class Usage {
+public:
+    std::int64_t live;
+    std::int64_t peak;
+};
+
+const char* name(const Category category);
+Usage usage(const Category category);
+
+// all categories together
+Usage total();
+
+void start();
+
+// live and peak bytes per category, then the lines that allocated the most
+void write_report(std::ostream& out, const std::string& script);
+
+} // namespace Memory
+} // namespace Runtime
+} // namespace ELang
@@ -0,0 +1,162 @@
+#include "output.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <unistd.h>
+
+using namespace ELang::Runtime;
+
+namespace {
+
+thread_local Capture* active_capture = nullptr;
+
+// Unbuffered, so every character is routed at write time: a stream shared by
+// all threads can't keep a put area that belongs to one of them.
+class RoutingBuffer: public std::streambuf {
+public:
+    explicit RoutingBuffer(std::streambuf* fallback): fallback(fallback) { }
+
+protected:
+    int overflow(int c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+
+        const auto ch = traits_type::to_char_type(c);
+        return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        const auto capture = active_capture;
+        if (nullptr == capture) {
+            return fallback->sputn(s, n);
+        }
+
+        std::lock_guard<std::mutex> lock(capture->mutex);
+        capture->text.append(s, n);
+        return n;
+    }
+
+    int sync() override {
+        return nullptr == active_capture ? fallback->pubsync() : 0;
+    }
+
+private:
+    std::streambuf* fallback;
+};
+
+std::atomic<bool> line_buffered(isatty(STDOUT_FILENO) == 1);
+
+// Also unbuffered from the stream's side, for the same reason; the bytes are
+// combined here instead, under a lock.
+class OutputBuffer: public std::streambuf {
+public:
+    explicit OutputBuffer(const int fd): fd(fd) {
+        pending.reserve(capacity);
+    }
+
+protected:
+    int overflow(int c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) {
+            return traits_type::not_eof(c);
+        }
+
+        const auto ch = traits_type::to_char_type(c);
+        return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (pending.size() + n > capacity && !drain()) {
+            return 0;
+        }
+
+        if (static_cast<std::size_t>(n) >= capacity) {
+            return write_fully(fd, s, n) ? n : 0;
+        }
+
+        pending.append(s, n);
+        if (line_buffered && nullptr != std::memchr(s, '\n', n) && !drain()) {
+            return 0;
+        }
+
+        return n;
+    }
+
+    int sync() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return drain() ? 0 : -1;
+    }
+
+private:
+    static constexpr std::size_t capacity = 64 * 1024;
+
+    const int fd;
+    std::string pending;
+    std::mutex mutex;
+
+    bool drain() {
+        const auto ok = write_fully(fd, pending.data(), pending.size());
+        pending.clear();
+        return ok;
+    }
+};
+
+} // namespace
+
+CaptureScope::CaptureScope(Capture* capture): previous(active_capture) {
+    active_capture = capture;
+}
+
+CaptureScope::~CaptureScope() {
+    active_capture = previous;
+}
+
+Capture* ELang::Runtime::current_capture() {
+    return active_capture;
+}
+
+void ELang::Runtime::install_output() {
+    // never destroyed: std::cout is still flushed after static destructors run
+    static const auto buffer = [] {
+        std::atexit([] { std::cout.flush(); });
+        return new OutputBuffer(STDOUT_FILENO);
+    }();
+
+    std::cout.rdbuf(buffer);
+}
+
+void ELang::Runtime::set_buffering(const Buffering mode) {
+    line_buffered = mode == Buffering::Line;
+}
+
+bool ELang::Runtime::write_fully(const int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        const auto written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+void ELang::Runtime::install_capture() {
+    static RoutingBuffer out(std::cout.rdbuf());
+    static RoutingBuffer err(std::cerr.rdbuf());
+
+    std::cout.rdbuf(&out);
+    std::cerr.rdbuf(&err);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace ELang {
+namespace Runtime {
+
+// Collects what a run prints instead of letting it reach stdout/stderr.
+// Several pool workers may write into the same capture at once.
+class Capture {
+public:
+    std::string text;
+    std::mutex mutex;
+};
+
+// Points the calling thread's output at `capture` (nullptr for the real
+// streams) until the scope ends. vm.cpp re-enters the scope on pool workers
+// and in tasks, so a capture follows its run wherever it executes.
+class CaptureScope {
+public:
+    explicit CaptureScope(Capture* capture);
+    ~CaptureScope();
+
+    CaptureScope(const CaptureScope&) = delete;
+    CaptureScope& operator=(const CaptureScope&) = delete;
+
+private:
+    Capture* previous;
+};
+
+Capture* current_capture();
+
+// Line buffering writes stdout out at every newline, full buffering only
+// when the buffer fills up or on an explicit flush.
+enum class Buffering { Line, Full };
+
+// Puts std::cout on a write-combining buffer over the stdout descriptor, so
+// printing costs a write(2) per buffer (or per line) instead of per value.
+// Starts line buffered on a terminal and fully buffered otherwise, like C
+// stdio, and is flushed at exit. Safe to share between threads. Install it
+// before `install_capture`, which then falls back to it.
+void install_output();
+void set_buffering(const Buffering mode);
+
+// write(2) until everything is out, retrying interrupted and short writes
+bool write_fully(const int fd, const char* data, std::size_t size);
+
+// Reroutes std::cout and std::cerr through the calling thread's capture, if
+// it has one. Needed once per process before any capture is used.
+void install_capture();
+
+} // namespace Runtime
+} // namespace ELang
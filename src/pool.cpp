@@ -0,0 +1,174 @@
+#include "pool.hpp"
+
+#include <algorithm>
+#include <exception>
+
+using namespace ELang::Runtime;
+
+namespace {
+
+// index of the calling thread's deque, 0 (the injection queue) for non-workers
+thread_local std::size_t current_queue = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(const std::size_t size): queued(0), stopping(false) {
+    queues.push_back(std::make_unique<Queue>());
+
+    for (std::size_t i = 1; i < size; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (std::size_t i = 1; i < size; ++i) {
+        workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        stopping = true;
+    }
+
+    available.notify_all();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+void ThreadPool::submit(const std::function<void()>& task) {
+    {
+        auto& queue = *queues[current_queue];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        queue.tasks.push_back(task);
+        ++queued;
+    }
+
+    // an idle worker either sees `queued` in its wait predicate or gets this
+    { std::lock_guard<std::mutex> lock(idle_mutex); }
+    available.notify_one();
+}
+
+bool ThreadPool::pop(const std::size_t index, const bool back, std::function<void()>& task) {
+    auto& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) {
+        return false;
+    }
+
+    if (back) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+    }
+    else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+    }
+
+    --queued;
+    return true;
+}
+
+bool ThreadPool::take(std::function<void()>& task) {
+    if (queued == 0) {
+        return false;
+    }
+
+    // own work first, newest first: it is the hottest in cache
+    const auto self = current_queue;
+    if (self != 0 && pop(self, true, task)) {
+        return true;
+    }
+
+    if (pop(0, false, task)) {
+        return true;
+    }
+
+    // steal the oldest task of someone else, those tend to be the biggest
+    for (std::size_t i = 1; i < queues.size(); ++i) {
+        const auto victim = (self + i) % queues.size();
+        if (victim != 0 && victim != self && pop(victim, false, task)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::help() {
+    std::function<void()> task;
+    if (!take(task)) {
+        return false;
+    }
+
+    task();
+    return true;
+}
+
+void ThreadPool::work(const std::size_t index) {
+    current_queue = index;
+
+    while (true) {
+        if (help()) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        available.wait(lock, [this] { return stopping || queued > 0; });
+
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::run(const std::size_t count, const std::function<void(std::size_t, std::size_t)>& chunk, const std::size_t min_count) {
+    if (count < min_count || count < 2 || workers.empty()) {
+        chunk(0, count);
+        return;
+    }
+
+    const auto chunks = std::min(count, size());
+    std::atomic<std::size_t> pending(chunks - 1);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    // first failure wins, the rest are dropped
+    const auto guarded = [&](const std::size_t i) {
+        try {
+            chunk(count * i / chunks, count * (i + 1) / chunks);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    for (std::size_t i = 1; i < chunks; ++i) {
+        submit([&, i] {
+            guarded(i);
+            --pending;
+        });
+    }
+
+    guarded(0);
+
+    while (pending > 0) {
+        if (!help()) {
+            std::this_thread::yield();
+        }
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ELang {
+namespace Runtime {
+
+// Work-stealing pool. Every worker owns a deque: it pushes and pops its own
+// tasks at the back and, once it runs dry, steals from the front of the other
+// deques. Threads that are not workers submit through a shared injection
+// queue. Nobody blocks while waiting on pool work: `help` runs one pending
+// task on the calling thread, so nested waits cannot starve the pool.
+class ThreadPool {
+public:
+    // below this many items a job is not worth splitting
+    static constexpr std::size_t grain = 256;
+
+    explicit ThreadPool(const std::size_t size);
+    ~ThreadPool();
+
+    static ThreadPool& instance();
+
+    inline std::size_t size() const { return workers.size() + 1; }
+    void submit(const std::function<void()>& task);
+    bool help();
+
+    // split [0, count) into one chunk per thread (the caller included) and
+    // return once all of them are done
+    void run(const std::size_t count, const std::function<void(std::size_t, std::size_t)>& chunk, const std::size_t min_count = grain);
+
+private:
+    class Queue {
+    public:
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues; // queues[0] is the injection queue
+    std::atomic<std::size_t> queued;
+    std::mutex idle_mutex;
+    std::condition_variable available;
+    bool stopping;
+
+    bool pop(const std::size_t index, const bool back, std::function<void()>& task);
+    bool take(std::function<void()>& task);
+    void work(const std::size_t index);
+};
+
+} // namespace Runtime
+} // namespace ELang
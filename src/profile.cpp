@@ -0,0 +1,391 @@
+#include "profile.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+
+using namespace ELang::Runtime;
+
+std::atomic<bool> Profile::enabled(false);
+
+namespace {
+
+// frames past this depth are not recorded, their samples end in "(deeper)"
+constexpr std::size_t stack_capacity = 256;
+
+// samples waiting for the collector, a power of two
+constexpr std::size_t queue_capacity = 512;
+
+class Entry {
+public:
+    Profile::Function* function;
+    std::atomic<int> line;
+};
+
+// Written by its own thread only. The signal handler reads it on that same
+// thread, so compiler fences are all the ordering it needs. Trivially
+// constructible: no lazy TLS initialisation can run inside the handler.
+class Stack {
+public:
+    Entry entries[stack_capacity];
+    std::atomic<std::size_t> depth;
+};
+
+thread_local Stack stack;
+
+// a copy of one stack, outermost frame first
+class Sample {
+public:
+    std::size_t depth;
+    bool truncated;
+    Profile::Function* functions[stack_capacity];
+    int lines[stack_capacity];
+};
+
+// Bounded MPMC queue (Vyukov). Pushing never blocks or allocates, so it is
+// safe from a signal handler on any thread; a full queue drops the sample.
+class Queue {
+public:
+    Queue(): enqueued(0), dequeued(0) {
+        for (std::size_t i = 0; i < queue_capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const Stack& source) {
+        auto position = enqueued.load(std::memory_order_relaxed);
+
+        for (;;) {
+            auto& cell = cells[position & (queue_capacity - 1)];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+            if (difference == 0) {
+                if (enqueued.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    copy(source, cell.sample);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = enqueued.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(Sample& sample) {
+        auto position = dequeued.load(std::memory_order_relaxed);
+
+        for (;;) {
+            auto& cell = cells[position & (queue_capacity - 1)];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+
+            if (difference == 0) {
+                if (dequeued.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    sample = cell.sample;
+                    cell.sequence.store(position + queue_capacity, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0) {
+                return false;
+            }
+            else {
+                position = dequeued.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    class Cell {
+    public:
+        std::atomic<std::size_t> sequence;
+        Sample sample;
+    };
+
+    Cell cells[queue_capacity];
+    alignas(64) std::atomic<std::size_t> enqueued;
+    alignas(64) std::atomic<std::size_t> dequeued;
+
+    static void copy(const Stack& source, Sample& sample) {
+        const auto depth = source.depth.load(std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_acquire);
+
+        sample.truncated = depth > stack_capacity;
+        sample.depth = std::min(depth, stack_capacity);
+        for (std::size_t i = 0; i < sample.depth; ++i) {
+            sample.functions[i] = source.entries[i].function;
+            sample.lines[i] = source.entries[i].line.load(std::memory_order_relaxed);
+        }
+    }
+};
+
+class Totals {
+public:
+    std::uint64_t self = 0;
+    std::uint64_t total = 0;
+};
+
+// what the collector has folded so far; read by the reports once it stopped
+class Aggregate {
+public:
+    std::uint64_t samples = 0;
+    std::uint64_t untracked = 0;
+    std::uint64_t truncated = 0;
+    std::unordered_map<const Profile::Function*, Totals> functions;
+    std::map<std::pair<const Profile::Function*, int>, std::uint64_t> lines;
+    std::unordered_map<std::string, std::uint64_t> stacks;
+
+    void add(const Sample& sample) {
+        ++samples;
+
+        // pool workers run parallel loop bodies outside of any E call
+        if (sample.depth == 0) {
+            ++untracked;
+            ++stacks["(worker)"];
+            return;
+        }
+
+        auto folded = std::string();
+        for (std::size_t i = 0; i < sample.depth; ++i) {
+            const auto function = sample.functions[i];
+
+            // recursion counts once towards a function's total
+            if (std::find(sample.functions, sample.functions + i, function) == sample.functions + i) {
+                ++functions[function].total;
+            }
+
+            if (i > 0) {
+                folded.push_back(';');
+            }
+            folded.append(function->name);
+        }
+
+        if (sample.truncated) {
+            ++truncated;
+            folded.append(";(deeper)");
+        }
+        else {
+            const auto leaf = sample.functions[sample.depth - 1];
+            ++functions[leaf].self;
+            ++lines[std::make_pair(leaf, sample.lines[sample.depth - 1])];
+        }
+
+        ++stacks[folded];
+    }
+};
+
+std::mutex registry_mutex;
+std::map<std::string, std::unique_ptr<Profile::Function>> registry;
+
+std::atomic<Queue*> queue(nullptr);
+std::atomic<std::uint64_t> dropped(0);
+unsigned sample_frequency = 0;
+
+// the kernel may tick slower than asked, times come from the CPU clock instead
+double cpu_seconds = 0.0;
+
+Aggregate aggregate;
+std::thread collector;
+std::mutex collector_mutex;
+std::condition_variable wake;
+bool stopping = false;
+
+void on_sample(int) {
+    const auto saved = errno;
+
+    const auto target = queue.load(std::memory_order_relaxed);
+    if (nullptr != target && !target->push(stack)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    errno = saved;
+}
+
+void collect() {
+    // a sample is 6 KiB, better on the heap than on the stack
+    const auto sample = std::make_unique<Sample>();
+    const auto source = queue.load(std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> lock(collector_mutex);
+    for (;;) {
+        const auto done = stopping;
+
+        lock.unlock();
+        while (source->pop(*sample)) {
+            aggregate.add(*sample);
+        }
+        lock.lock();
+
+        if (done) {
+            return;
+        }
+        wake.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+double cpu_clock() {
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+double percent(const std::uint64_t count, const std::uint64_t samples) {
+    return samples == 0 ? 0.0 : 100.0 * count / samples;
+}
+
+} // namespace
+
+Profile::Function* Profile::declare(const std::string& name) {
+    if (!active()) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& function = registry[name];
+    if (nullptr == function) {
+        function = std::make_unique<Function>(name);
+    }
+
+    return function.get();
+}
+
+void Profile::Frame::enter(Function* function) {
+    function->calls.fetch_add(1, std::memory_order_relaxed);
+
+    const auto depth = stack.depth.load(std::memory_order_relaxed);
+    if (depth < stack_capacity) {
+        stack.entries[depth].function = function;
+        stack.entries[depth].line.store(0, std::memory_order_relaxed);
+    }
+
+    // the entry is complete before the handler can see it counted
+    std::atomic_signal_fence(std::memory_order_release);
+    stack.depth.store(depth + 1, std::memory_order_relaxed);
+}
+
+void Profile::Frame::leave() {
+    stack.depth.store(stack.depth.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+void Profile::line(const int line) {
+    const auto depth = stack.depth.load(std::memory_order_relaxed);
+    if (depth > 0 && depth <= stack_capacity) {
+        stack.entries[depth - 1].line.store(line, std::memory_order_relaxed);
+    }
+}
+
+void Profile::start(const unsigned frequency) {
+    sample_frequency = std::max(1u, frequency);
+    cpu_seconds = cpu_clock();
+    queue.store(new Queue(), std::memory_order_relaxed);
+    enabled.store(true);
+
+    // the collector inherits a mask with SIGPROF blocked, it has no stack to sample
+    sigset_t profiling, previous;
+    sigemptyset(&profiling);
+    sigaddset(&profiling, SIGPROF);
+    pthread_sigmask(SIG_BLOCK, &profiling, &previous);
+    collector = std::thread(collect);
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+    struct sigaction action = {};
+    action.sa_handler = on_sample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+
+    struct itimerval timer = {};
+    timer.it_interval.tv_usec = 1000000 / sample_frequency;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+}
+
+void Profile::stop() {
+    if (!collector.joinable()) {
+        return;
+    }
+
+    struct itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    signal(SIGPROF, SIG_IGN);
+    enabled.store(false);
+    cpu_seconds = cpu_clock() - cpu_seconds;
+
+    {
+        std::lock_guard<std::mutex> lock(collector_mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    collector.join();
+}
+
+void Profile::write_report(std::ostream& out, const std::string& script) {
+    const auto samples = aggregate.samples;
+    const auto seconds = [samples](const std::uint64_t count) { return samples == 0 ? 0.0 : cpu_seconds * count / samples; };
+
+    auto rows = std::vector<std::pair<const Function*, Totals>>(aggregate.functions.cbegin(), aggregate.functions.cend());
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return a.second.self != b.second.self ? a.second.self > b.second.self : a.second.total > b.second.total;
+    });
+
+    out << std::fixed << std::setprecision(1)
+        << "Profile of " << script << ": " << samples << " samples, "
+        << std::setprecision(3) << cpu_seconds << "s of CPU" << std::endl << std::endl;
+
+    out << "  self %   self s  total %  total s       calls  function" << std::endl;
+    for (const auto& row: rows) {
+        out << std::setprecision(1) << std::setw(8) << percent(row.second.self, samples)
+            << std::setprecision(3) << std::setw(9) << seconds(row.second.self)
+            << std::setprecision(1) << std::setw(9) << percent(row.second.total, samples)
+            << std::setprecision(3) << std::setw(9) << seconds(row.second.total)
+            << std::setw(12) << row.first->calls.load() << "  " << row.first->name << std::endl;
+    }
+
+    auto lines = std::vector<std::pair<std::pair<const Function*, int>, std::uint64_t>>(aggregate.lines.cbegin(), aggregate.lines.cend());
+    std::sort(lines.begin(), lines.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    lines.resize(std::min<std::size_t>(lines.size(), 10));
+
+    out << std::endl << "Hottest lines:" << std::endl;
+    for (const auto& line: lines) {
+        out << std::setprecision(1) << std::setw(8) << percent(line.second, samples)
+            << std::setprecision(3) << std::setw(9) << seconds(line.second)
+            << "  " << script << ":" << line.first.second << " in " << line.first.first->name << std::endl;
+    }
+
+    if (aggregate.untracked > 0) {
+        out << std::endl << aggregate.untracked << " samples on pool workers outside any function" << std::endl;
+    }
+    if (aggregate.truncated > 0) {
+        out << aggregate.truncated << " samples deeper than " << stack_capacity << " calls" << std::endl;
+    }
+    if (dropped.load() > 0) {
+        out << dropped.load() << " samples dropped" << std::endl;
+    }
+
+    out << std::defaultfloat;
+}
+
+void Profile::write_collapsed(std::ostream& out) {
+    for (const auto& stack: aggregate.stacks) {
+        out << stack.first << " " << stack.second << "\n";
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace ELang {
+namespace Runtime {
+namespace Profile {
+
+// Sampling profiler behind `elc --profile`. Every thread keeps a shadow stack
+// of the E functions it is running and the line each one is at; a SIGPROF
+// timer copies the interrupted thread's stack into a lock-free queue and a
+// collector thread folds the samples into per-function and per-line counts.
+// Timing is CPU time, so a thread blocked in fetch or I/O is not sampled.
+
+// one per function name, alive until the process exits
+class Function {
+public:
+    std::string name;
+    std::atomic<std::uint64_t> calls;
+
+    explicit Function(const std::string& name): name(name), calls(0) { }
+};
+
+extern std::atomic<bool> enabled;
+
+inline bool active() { return enabled.load(std::memory_order_relaxed); }
+
+// the entry for `name`, or nullptr when not profiling so callers skip frames
+Function* declare(const std::string& name);
+
+// Marks a call to `function` on the calling thread for as long as it lives.
+// A null function is a no-op, which is what every call is without a profile.
+class Frame {
+public:
+    explicit Frame(Function* function): function(function) {
+        if (nullptr != function) {
+            enter(function);
+        }
+    }
+
+    ~Frame() {
+        if (nullptr != function) {
+            leave();
+        }
+    }
+
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+
+private:
+    Function* function;
+
+    static void enter(Function* function);
+    static void leave();
+};
+
+// the statement the innermost frame of this thread is executing
+void line(const int line);
+
+// starts sampling every thread at `frequency` Hz; once per process
+void start(const unsigned frequency = 1000);
+void stop();
+
+// per-function self/total time and call counts, then the hottest lines
+void write_report(std::ostream& out, const std::string& script);
+
+// one `root;caller;callee count` line per distinct stack, the input format
+// of flamegraph.pl, speedscope and friends
+void write_collapsed(std::ostream& out);
+
+} // namespace Profile
+} // namespace Runtime
+} // namespace ELang
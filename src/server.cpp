@@ -0,0 +1,305 @@
+#include "server.hpp"
+#include "elc.hpp"
+#include "output.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace ELang;
+using namespace ELang::Runtime;
+
+namespace {
+
+class Connection {
+public:
+    explicit Connection(const int fd): fd(fd) { }
+    ~Connection() { close(fd); }
+
+    bool read_line(std::string& line) {
+        while (true) {
+            const auto end = buffer.find('\n');
+            if (end != std::string::npos) {
+                line = buffer.substr(0, end);
+                buffer.erase(0, end + 1);
+                return true;
+            }
+
+            if (!fill()) {
+                return false;
+            }
+        }
+    }
+
+    bool read_exact(const std::size_t length, std::string& data) {
+        while (buffer.length() < length) {
+            if (!fill()) {
+                return false;
+            }
+        }
+
+        data = buffer.substr(0, length);
+        buffer.erase(0, length);
+        return true;
+    }
+
+    bool reply(const bool ok, const std::string& body) {
+        const auto message = (ok ? "OK " : "ERR ") + std::to_string(body.length()) + "\n" + body;
+
+        for (std::size_t sent = 0; sent < message.length();) {
+            const auto n = send(fd, message.data() + sent, message.length() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+
+            sent += n;
+        }
+
+        return true;
+    }
+
+private:
+    int fd;
+    std::string buffer;
+
+    bool fill() {
+        char chunk[4096];
+
+        while (true) {
+            const auto n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+
+            buffer.append(chunk, n);
+            return true;
+        }
+    }
+};
+
+// programs kept by PREPARE, shared by every worker
+class Registry {
+public:
+    std::size_t add(const std::shared_ptr<const Program>& program) {
+        std::lock_guard<std::mutex> lock(mutex);
+        programs[++last_id] = program;
+        return last_id;
+    }
+
+    std::shared_ptr<const Program> find(const std::size_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = programs.find(id);
+        return it == programs.end() ? nullptr : it->second;
+    }
+
+    // runs already executing it keep the program alive until they finish
+    bool remove(const std::size_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return programs.erase(id) > 0;
+    }
+
+private:
+    std::map<std::size_t, std::shared_ptr<const Program>> programs;
+    std::size_t last_id = 0;
+    std::mutex mutex;
+};
+
+// RUN and PREPARE payloads above this are refused before reading them
+constexpr std::size_t max_source = 16 * 1024 * 1024;
+
+// false on anything but plain digits, or a value that doesn't fit
+bool parse_number(const std::string& text, std::size_t& value) {
+    if (text.empty() || !std::all_of(text.cbegin(), text.cend(), [](const char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+
+    const auto end = text.data() + text.length();
+    const auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// runs `program` with the calling thread's output captured into the reply
+bool execute(Engine& engine, const Program& program, std::string& output) {
+    Capture capture;
+    auto ok = true;
+
+    {
+        const CaptureScope scope(&capture);
+        try {
+            engine.run(program);
+        }
+        catch (...) {
+            ok = false;
+        }
+    }
+
+    output = std::move(capture.text);
+    return ok;
+}
+
+void handle(Engine& engine, Registry& registry, Connection& connection) {
+    auto line = std::string();
+
+    while (connection.read_line(line)) {
+        const auto space = line.find(' ');
+        const auto command = line.substr(0, space);
+        const auto argument = space == std::string::npos ? std::string() : line.substr(space + 1);
+        auto number = std::size_t(0);
+
+        if (!parse_number(argument, number)) {
+            connection.reply(false, "Invalid request.\n");
+            return;
+        }
+
+        if (command == "RUN" || command == "PREPARE") {
+            // the payload is never read, so the connection can't go on either
+            if (number > max_source) {
+                connection.reply(false, "Program too large.\n");
+                return;
+            }
+
+            auto source = std::string();
+            if (!connection.read_exact(number, source)) {
+                return;
+            }
+
+            // syntax errors are printed by the parser, capture them too
+            Capture capture;
+            auto program = std::shared_ptr<const Program>();
+            {
+                const CaptureScope scope(&capture);
+                program = Program::compile(source);
+            }
+
+            if (nullptr == program) {
+                connection.reply(false, capture.text);
+            }
+            else if (command == "PREPARE") {
+                connection.reply(true, std::to_string(registry.add(program)));
+            }
+            else {
+                auto output = std::string();
+                const auto ok = execute(engine, *program, output);
+                connection.reply(ok, output);
+            }
+        }
+        else if (command == "EXEC") {
+            const auto program = registry.find(number);
+            if (nullptr == program) {
+                connection.reply(false, "Unknown program.\n");
+                continue;
+            }
+
+            auto output = std::string();
+            const auto ok = execute(engine, *program, output);
+            connection.reply(ok, output);
+        }
+        else if (command == "DROP") {
+            if (registry.remove(number)) {
+                connection.reply(true, "");
+            }
+            else {
+                connection.reply(false, "Unknown program.\n");
+            }
+        }
+        else {
+            connection.reply(false, "Invalid request.\n");
+            return;
+        }
+    }
+}
+
+} // namespace
+
+int ELang::serve(const std::string& path) {
+    const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Error: socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    auto address = sockaddr_un();
+    address.sun_family = AF_UNIX;
+    if (path.length() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: socket path too long" << std::endl;
+        return 1;
+    }
+
+    std::strcpy(address.sun_path, path.c_str());
+
+    // a stale socket from an earlier server is replaced, anything else is kept
+    struct stat existing;
+    if (lstat(path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            std::cerr << "Error: " << path << ": exists and is not a socket" << std::endl;
+            close(listener);
+            return 1;
+        }
+        unlink(path.c_str());
+    }
+
+    // owner only: clients run scripts, and scripts read and write files as us.
+    // No other thread runs yet, so the process-wide umask is safe to swap.
+    const auto previous_mask = umask(077);
+    const auto bound = bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    umask(previous_mask);
+
+    if (!bound || listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Error: " << path << ": " << std::strerror(errno) << std::endl;
+        close(listener);
+        return 1;
+    }
+
+    install_capture();
+
+    Registry registry;
+    auto workers = std::vector<std::thread>();
+
+    // one warm engine per worker, every worker accepts on the same socket. An
+    // open connection holds its worker even while idle, so keep a few around
+    // on small machines too
+    for (auto i = 0u; i < std::max(4u, std::thread::hardware_concurrency()); ++i) {
+        workers.emplace_back([listener, &registry] {
+            Engine engine;
+
+            while (true) {
+                const auto fd = accept(listener, nullptr, nullptr);
+                if (fd < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) {
+                        continue;
+                    }
+
+                    std::cerr << "Error: accept: " << std::strerror(errno) << std::endl;
+                    return;
+                }
+
+                Connection connection(fd);
+                handle(engine, registry, connection);
+            }
+        });
+    }
+
+    for (auto& worker: workers) {
+        worker.join();
+    }
+
+    close(listener);
+    return 1;
+}
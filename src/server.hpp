@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+namespace ELang {
+
+// `elc --serve path`: keeps warm engines behind a Unix domain socket so
+// clients skip process start, builtin registration and, for prepared
+// programs, parsing. Requests on a connection are handled in order:
+//
+//   RUN <n>\n<n bytes of source>    parse and run once
+//   PREPARE <n>\n<n bytes>          parse and keep, replies with an id
+//   EXEC <id>\n                     run a prepared program
+//   DROP <id>\n                     forget a prepared program, freeing it
+//
+// Every reply is `OK <n>\n` or `ERR <n>\n` followed by n bytes: whatever
+// the run printed (errors included), or the id for PREPARE. Malformed
+// requests and sources over 16 MiB get an ERR reply and close the connection.
+// The socket is created owner-only and replaces only an earlier socket at
+// `path`, never another kind of file. Returns only if it can't be set up.
+int serve(const std::string& path);
+
+} // namespace ELang
@@ -0,0 +1,301 @@
+#include "simd.hpp"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ELANG_SIMD_X86
+#endif
+
+using namespace ELang::Runtime;
+
+namespace {
+
+std::size_t find_scalar(const char* haystack, const std::size_t n, const char* needle, const std::size_t k) {
+    return std::string_view(haystack, n).find(std::string_view(needle, k));
+}
+
+template<char From>
+void flip_case_scalar(char* data, const std::size_t length) {
+    for (std::size_t i = 0; i < length; ++i) {
+        if (data[i] >= From && data[i] <= From + 25) {
+            data[i] ^= 0x20;
+        }
+    }
+}
+
+#ifdef ELANG_SIMD_X86
+
+bool has_avx2() {
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return supported;
+}
+
+// Candidate positions are the ones where both the first and the last byte of
+// the needle match; only those are verified with memcmp. Needles of length 1
+// never get here (memchr is already vectorized by libc).
+std::size_t find_sse2(const char* haystack, const std::size_t n, const char* needle, const std::size_t k) {
+    const auto first = _mm_set1_epi8(needle[0]);
+    const auto last = _mm_set1_epi8(needle[k - 1]);
+
+    std::size_t i = 0;
+    for (; i + k + 15 <= n; i += 16) {
+        const auto block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+        const auto block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + k - 1));
+
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+
+        while (mask != 0) {
+            const auto bit = __builtin_ctz(mask);
+            if (std::memcmp(haystack + i + bit + 1, needle + 1, k - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    const auto tail = find_scalar(haystack + i, n - i, needle, k);
+    return tail == std::string_view::npos ? tail : i + tail;
+}
+
+__attribute__((target("avx2")))
+std::size_t find_avx2(const char* haystack, const std::size_t n, const char* needle, const std::size_t k) {
+    const auto first = _mm256_set1_epi8(needle[0]);
+    const auto last = _mm256_set1_epi8(needle[k - 1]);
+
+    std::size_t i = 0;
+    for (; i + k + 31 <= n; i += 32) {
+        const auto block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+        const auto block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + k - 1));
+
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last))));
+
+        while (mask != 0) {
+            const auto bit = __builtin_ctz(mask);
+            if (std::memcmp(haystack + i + bit + 1, needle + 1, k - 2) == 0) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    const auto tail = find_sse2(haystack + i, n - i, needle, k);
+    return tail == std::string_view::npos ? tail : i + tail;
+}
+
+// Bytes in [From, From + 25] get bit 0x20 flipped. The range check is done with
+// a single signed compare by shifting the range down to [-128, -103].
+template<char From>
+void flip_case_sse2(char* data, const std::size_t length) {
+    const auto shift = _mm_set1_epi8(static_cast<char>(0x80 - From));
+    const auto bound = _mm_set1_epi8(static_cast<char>(0x80 + 26));
+    const auto flip = _mm_set1_epi8(0x20);
+
+    std::size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const auto in_range = _mm_cmplt_epi8(_mm_add_epi8(block, shift), bound);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_xor_si128(block, _mm_and_si128(in_range, flip)));
+    }
+
+    flip_case_scalar<From>(data + i, length - i);
+}
+
+template<char From>
+__attribute__((target("avx2")))
+void flip_case_avx2(char* data, const std::size_t length) {
+    const auto shift = _mm256_set1_epi8(static_cast<char>(0x80 - From));
+    const auto bound = _mm256_set1_epi8(static_cast<char>(0x80 + 26));
+    const auto flip = _mm256_set1_epi8(0x20);
+
+    std::size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const auto in_range = _mm256_cmpgt_epi8(bound, _mm256_add_epi8(block, shift));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_xor_si256(block, _mm256_and_si256(in_range, flip)));
+    }
+
+    flip_case_sse2<From>(data + i, length - i);
+}
+
+// 256 mask bits per instruction
+__attribute__((target("avx2")))
+void mask_and_avx2(const std::uint64_t* lhs, const std::uint64_t* rhs, std::uint64_t* result, const std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), _mm256_and_si256(a, b));
+    }
+
+    for (; i < count; ++i) {
+        result[i] = lhs[i] & rhs[i];
+    }
+}
+
+__attribute__((target("avx2")))
+void mask_or_avx2(const std::uint64_t* lhs, const std::uint64_t* rhs, std::uint64_t* result, const std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), _mm256_or_si256(a, b));
+    }
+
+    for (; i < count; ++i) {
+        result[i] = lhs[i] | rhs[i];
+    }
+}
+
+__attribute__((target("avx2")))
+void mask_not_avx2(const std::uint64_t* source, std::uint64_t* result, const std::size_t count) {
+    const auto ones = _mm256_set1_epi8(static_cast<char>(0xff));
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), _mm256_xor_si256(a, ones));
+    }
+
+    for (; i < count; ++i) {
+        result[i] = ~source[i];
+    }
+}
+
+// Nibble lookup through vpshufb, byte counts summed per 64-bit lane with vpsadbw.
+__attribute__((target("avx2")))
+std::size_t popcount_avx2(const std::uint64_t* words, const std::size_t count) {
+    const auto lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const auto low = _mm256_set1_epi8(0x0f);
+    auto acc = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words + i));
+        const auto lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(block, low));
+        const auto hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(block, 4), low));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+    }
+
+    std::size_t total = _mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1)
+        + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3);
+
+    for (; i < count; ++i) {
+        total += __builtin_popcountll(words[i]);
+    }
+
+    return total;
+}
+
+#endif // ELANG_SIMD_X86
+
+template<char From>
+void flip_case(char* data, const std::size_t length) {
+#ifdef ELANG_SIMD_X86
+    if (has_avx2()) {
+        flip_case_avx2<From>(data, length);
+    }
+    else {
+        flip_case_sse2<From>(data, length);
+    }
+#else
+    flip_case_scalar<From>(data, length);
+#endif // ELANG_SIMD_X86
+}
+
+} // namespace
+
+std::size_t Simd::find(const std::string_view haystack, const std::string_view needle, const std::size_t from) {
+    if (from > haystack.length()) {
+        return std::string_view::npos;
+    }
+
+    const auto start = haystack.data() + from;
+    const auto n = haystack.length() - from;
+    const auto k = needle.length();
+    std::size_t pos;
+
+    if (k == 0) {
+        return from;
+    }
+    else if (k > n) {
+        return std::string_view::npos;
+    }
+    else if (k == 1) {
+        const auto found = static_cast<const char*>(std::memchr(start, needle[0], n));
+        return nullptr == found ? std::string_view::npos : found - haystack.data();
+    }
+
+#ifdef ELANG_SIMD_X86
+    pos = has_avx2() ? find_avx2(start, n, needle.data(), k) : find_sse2(start, n, needle.data(), k);
+#else
+    pos = find_scalar(start, n, needle.data(), k);
+#endif // ELANG_SIMD_X86
+
+    return pos == std::string_view::npos ? pos : from + pos;
+}
+
+void Simd::to_lower(char* data, const std::size_t length) {
+    flip_case<'A'>(data, length);
+}
+
+void Simd::to_upper(char* data, const std::size_t length) {
+    flip_case<'a'>(data, length);
+}
+
+void Simd::mask_and(const std::uint64_t* lhs, const std::uint64_t* rhs, std::uint64_t* result, const std::size_t count) {
+#ifdef ELANG_SIMD_X86
+    if (has_avx2()) {
+        mask_and_avx2(lhs, rhs, result, count);
+        return;
+    }
+#endif // ELANG_SIMD_X86
+
+    for (std::size_t i = 0; i < count; ++i) {
+        result[i] = lhs[i] & rhs[i];
+    }
+}
+
+void Simd::mask_or(const std::uint64_t* lhs, const std::uint64_t* rhs, std::uint64_t* result, const std::size_t count) {
+#ifdef ELANG_SIMD_X86
+    if (has_avx2()) {
+        mask_or_avx2(lhs, rhs, result, count);
+        return;
+    }
+#endif // ELANG_SIMD_X86
+
+    for (std::size_t i = 0; i < count; ++i) {
+        result[i] = lhs[i] | rhs[i];
+    }
+}
+
+void Simd::mask_not(const std::uint64_t* source, std::uint64_t* result, const std::size_t count) {
+#ifdef ELANG_SIMD_X86
+    if (has_avx2()) {
+        mask_not_avx2(source, result, count);
+        return;
+    }
+#endif // ELANG_SIMD_X86
+
+    for (std::size_t i = 0; i < count; ++i) {
+        result[i] = ~source[i];
+    }
+}
+
+std::size_t Simd::popcount(const std::uint64_t* words, const std::size_t count) {
+#ifdef ELANG_SIMD_X86
+    if (has_avx2()) {
+        return popcount_avx2(words, count);
+    }
+#endif // ELANG_SIMD_X86
+
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        total += __builtin_popcountll(words[i]);
+    }
+
+    return total;
+}
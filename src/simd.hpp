@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace ELang {
+namespace Runtime {
+namespace Simd {
+
+// substring search, returns std::string_view::npos when `needle` is not found
+std::size_t find(const std::string_view haystack, const std::string_view needle, const std::size_t from = 0);
+
+// ASCII case conversion, in place
+void to_lower(char* data, const std::size_t length);
+void to_upper(char* data, const std::size_t length);
+
+// bitwise kernels over packed masks of `count` 64-bit words
+void mask_and(const std::uint64_t* lhs, const std::uint64_t* rhs, std::uint64_t* result, const std::size_t count);
+void mask_or(const std::uint64_t* lhs, const std::uint64_t* rhs, std::uint64_t* result, const std::size_t count);
+void mask_not(const std::uint64_t* source, std::uint64_t* result, const std::size_t count);
+std::size_t popcount(const std::uint64_t* words, const std::size_t count);
+
+} // namespace Simd
+} // namespace Runtime
+} // namespace ELang
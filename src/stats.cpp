@@ -0,0 +1,169 @@
+#include "stats.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+using namespace ELang;
+using namespace ELang::Runtime;
+
+std::atomic<bool> Stats::enabled(false);
+
+namespace {
+
+class Kind {
+public:
+    const std::type_info* type;
+    const char* name;
+};
+
+// most frequent first, they are searched in order
+const Kind kinds[] = {
+    {&typeid(Meta::Identifier), "Identifier"},
+    {&typeid(Meta::Integer), "Integer"},
+    {&typeid(Meta::ArithmeticExpression), "ArithmeticExpression"},
+    {&typeid(Meta::FunctionCall), "FunctionCall"},
+    {&typeid(Meta::ComparisonExpression), "ComparisonExpression"},
+    {&typeid(Meta::ExpressionStatement), "ExpressionStatement"},
+    {&typeid(Meta::Assignment), "Assignment"},
+    {&typeid(Meta::IfStatement), "IfStatement"},
+    {&typeid(Meta::IndexExpression), "IndexExpression"},
+    {&typeid(Meta::Float), "Float"},
+    {&typeid(Meta::Boolean), "Boolean"},
+    {&typeid(Meta::String), "String"},
+    {&typeid(Meta::BinaryExpression), "BinaryExpression"},
+    {&typeid(Meta::NegatedBinaryExpression), "NegatedBinaryExpression"},
+    {&typeid(Meta::RangeExpression), "RangeExpression"},
+    {&typeid(Meta::SearchExpression), "SearchExpression"},
+    {&typeid(Meta::VectorExpression), "VectorExpression"},
+    {&typeid(Meta::YieldStatement), "YieldStatement"},
+    {&typeid(Meta::ForLoop), "ForLoop"},
+    {&typeid(Meta::ParallelForLoop), "ParallelForLoop"},
+    {&typeid(Meta::WhileLoop), "WhileLoop"},
+    {&typeid(Meta::Function), "Function"},
+};
+
+constexpr std::size_t kind_count = sizeof(kinds) / sizeof(kinds[0]);
+constexpr std::size_t counter_count = static_cast<std::size_t>(Stats::Counter::Count);
+
+// Only the owning thread writes its slots, with plain loads and stores: no
+// locked instructions on the counting path. The report reads them once the
+// run is over.
+class Counters {
+public:
+    std::atomic<std::uint64_t> counters[counter_count];
+    std::atomic<std::uint64_t> nodes[kind_count + 1]; // the last one for unknown kinds
+};
+
+std::mutex registry_mutex;
+std::vector<Counters*> registry;
+
+thread_local Counters* local = nullptr;
+
+Counters& counters() {
+    if (nullptr == local) {
+        // value-initialised, so zeroed; kept until exit like the threads
+        local = new Counters();
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(local);
+    }
+
+    return *local;
+}
+
+inline void bump(std::atomic<std::uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+std::uint64_t node_total(const std::size_t index) {
+    auto sum = std::uint64_t(0);
+    for (const auto counters: registry) {
+        sum += counters->nodes[index].load(std::memory_order_relaxed);
+    }
+
+    return sum;
+}
+
+std::uint64_t total(const Stats::Counter counter) {
+    auto sum = std::uint64_t(0);
+    for (const auto counters: registry) {
+        sum += counters->counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    return sum;
+}
+
+void write_row(std::ostream& out, const std::uint64_t count, const char* label) {
+    out << std::setw(14) << count << "  " << label << std::endl;
+}
+
+} // namespace
+
+void Stats::increment(const Counter counter) {
+    bump(counters().counters[static_cast<std::size_t>(counter)]);
+}
+
+void Stats::increment(const Meta::Node& node) {
+    const auto& type = typeid(node);
+
+    auto index = std::size_t(0);
+    while (index < kind_count && *kinds[index].type != type) {
+        ++index;
+    }
+
+    bump(counters().nodes[index]);
+}
+
+void Stats::start() {
+    enabled.store(true);
+}
+
+void Stats::write_report(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    auto nodes = std::vector<std::pair<std::uint64_t, const char*>>();
+    auto evaluations = std::uint64_t(0);
+    for (std::size_t i = 0; i <= kind_count; ++i) {
+        const auto count = node_total(i);
+        if (count > 0) {
+            nodes.emplace_back(count, i < kind_count ? kinds[i].name : "(other)");
+            evaluations += count;
+        }
+    }
+    std::stable_sort(nodes.begin(), nodes.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    out << "Evaluated nodes:" << std::endl;
+    for (const auto& node: nodes) {
+        write_row(out, node.first, node.second);
+    }
+    write_row(out, evaluations, "total");
+
+    out << std::endl << "Calls:" << std::endl;
+    write_row(out, total(Counter::BuiltinCalls), "builtin");
+    write_row(out, total(Counter::CustomCalls), "custom");
+    write_row(out, total(Counter::Specialized), "specialized operators");
+
+    out << std::endl << "Method lookups:" << std::endl;
+    write_row(out, total(Counter::Lookups), "lookups");
+    write_row(out, total(Counter::ScopesSearched), "scopes searched");
+    write_row(out, total(Counter::OverloadsTried), "overloads tried");
+    write_row(out, total(Counter::LookupFailures), "failures");
+
+    out << std::endl << "Context frames:" << std::endl;
+    write_row(out, total(Counter::Contexts), "created");
+
+    out << std::endl << "Value allocations:" << std::endl;
+    write_row(out, total(Counter::VectorValues), "Vector");
+    write_row(out, total(Counter::StringValues), "String");
+    write_row(out, total(Counter::FunctionValues), "Function");
+    write_row(out, total(Counter::MatrixValues), "Matrix");
+    write_row(out, total(Counter::MaskValues), "Mask");
+    write_row(out, total(Counter::TaskValues), "Task");
+    write_row(out, total(Counter::GeneratorValues), "Generator");
+    write_row(out, total(Counter::FileValues), "File");
+}
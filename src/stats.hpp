@@ -0,0 +1,62 @@
+#pragma once
+
+#include "elang.hpp"
+#include <atomic>
+#include <ostream>
+
+namespace ELang {
+namespace Runtime {
+namespace Stats {
+
+// Execution counters behind `elc --stats`. Compiled in, but `count` checks
+// `active()` first, so a run without the flag pays one predictable branch
+// per site. Threads count into their own slots, summed on report.
+
+enum class Counter {
+    BuiltinCalls,
+    CustomCalls,
+    Specialized,      // operators run by the kernel infer_types resolved
+    Lookups,          // name resolutions from call_function
+    ScopesSearched,   // frames locate_methods walked through
+    OverloadsTried,
+    LookupFailures,
+    Contexts,
+    VectorValues,
+    StringValues,
+    FunctionValues,
+    MatrixValues,
+    MaskValues,
+    TaskValues,
+    GeneratorValues,
+    FileValues,
+    Count,
+};
+
+extern std::atomic<bool> enabled;
+
+inline bool active() { return enabled.load(std::memory_order_relaxed); }
+
+void increment(const Counter counter);
+void increment(const Meta::Node& node);
+
+inline void count(const Counter counter) {
+    if (active()) {
+        increment(counter);
+    }
+}
+
+// one evaluation of a statement or expression, by node kind
+inline void count(const Meta::Node& node) {
+    if (active()) {
+        increment(node);
+    }
+}
+
+void start();
+
+// node counts, then dispatch, lookup, frame and allocation counters
+void write_report(std::ostream& out);
+
+} // namespace Stats
+} // namespace Runtime
+} // namespace ELang
@@ -0,0 +1,158 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace ELang::Runtime;
+
+std::atomic<bool> Trace::enabled(false);
+
+namespace {
+
+class Event {
+public:
+    const Trace::Name* name;
+    std::int64_t start;
+    std::int64_t duration;
+};
+
+// Written by its thread only; the exit report reads it once the run is over
+// and the pool is idle.
+class Ring {
+public:
+    std::vector<Event> events;
+    std::uint64_t written;
+    std::size_t thread;
+
+    Ring(const std::size_t capacity, const std::size_t thread): events(capacity), written(0), thread(thread) { }
+};
+
+std::mutex registry_mutex;
+std::map<std::pair<std::string, Trace::Kind>, std::unique_ptr<Trace::Name>> names;
+std::vector<std::unique_ptr<Ring>> rings;
+
+thread_local Ring* local = nullptr;
+
+std::int64_t threshold = 0;
+bool builtins = false;
+std::size_t capacity = 0;
+std::chrono::steady_clock::time_point origin;
+
+Ring& ring() {
+    if (nullptr == local) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        rings.push_back(std::make_unique<Ring>(capacity, rings.size() + 1));
+        local = rings.back().get();
+    }
+
+    return *local;
+}
+
+void write_string(std::ostream& out, const std::string& value) {
+    out << '"';
+    for (const auto c: value) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+const Trace::Name* Trace::declare(const std::string& name, const Kind kind) {
+    if (!active() || (kind == Kind::Builtin && !builtins)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& entry = names[std::make_pair(name, kind)];
+    if (nullptr == entry) {
+        entry = std::make_unique<Name>(name, kind);
+    }
+
+    return entry.get();
+}
+
+std::int64_t Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void Trace::record(const Name* name, const std::int64_t start) {
+    const auto duration = now() - start;
+    if (duration < threshold) {
+        return;
+    }
+
+    auto& mine = ring();
+    mine.events[mine.written % mine.events.size()] = Event{name, start, duration};
+    ++mine.written;
+}
+
+void Trace::start(const std::chrono::nanoseconds minimum, const bool with_builtins, const std::size_t events) {
+    threshold = minimum.count();
+    builtins = with_builtins;
+    capacity = std::max<std::size_t>(1, events);
+    origin = std::chrono::steady_clock::now();
+    enabled.store(true);
+
+    // the calling thread is the main one, it gets the first ring
+    ring();
+}
+
+bool Trace::write(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto overwritten = std::uint64_t(0);
+    auto first = true;
+
+    // timestamps are microseconds, kept to the nanosecond
+    out << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for (const auto& ring: rings) {
+        const auto thread_name = ring->thread == 1 ? std::string("main") : "thread " + std::to_string(ring->thread);
+        out << (first ? "\n" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->thread << ",\"args\":{\"name\":";
+        write_string(out, thread_name);
+        out << "}}";
+        first = false;
+
+        // oldest first: once the ring wrapped, that is the slot written next
+        const auto size = ring->events.size();
+        const auto count = std::min<std::uint64_t>(ring->written, size);
+        overwritten += ring->written - count;
+
+        for (std::uint64_t i = ring->written - count; i < ring->written; ++i) {
+            const auto& event = ring->events[i % size];
+
+            out << ",\n{\"name\":";
+            write_string(out, event.name->name);
+            out << ",\"cat\":\"" << (event.name->kind == Kind::Builtin ? "builtin" : "function")
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->thread
+                << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+
+    if (overwritten > 0) {
+        std::cerr << "Trace: " << overwritten << " older calls overwritten, " << capacity << " kept per thread" << std::endl;
+    }
+
+    return static_cast<bool>(out.flush());
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ELang {
+namespace Runtime {
+namespace Trace {
+
+// Call tracing behind `elc --trace out.json`. Each call through `invoke` to
+// a traced method is timed; calls lasting at least the threshold land in a
+// ring buffer owned by the calling thread, which keeps the most recent
+// events once it is full. At exit the buffers are written as Chrome
+// trace-event JSON, for chrome://tracing or Perfetto.
+
+enum class Kind { Custom, Builtin };
+
+// interned, alive until the process exits
+class Name {
+public:
+    std::string name;
+    Kind kind;
+
+    Name(const std::string& name, const Kind kind): name(name), kind(kind) { }
+};
+
+extern std::atomic<bool> enabled;
+
+inline bool active() { return enabled.load(std::memory_order_relaxed); }
+
+// what calls to the method named `name` are recorded as; nullptr when they
+// are not traced, which is always the case without `start`
+const Name* declare(const std::string& name, const Kind kind);
+
+std::int64_t now();
+void record(const Name* name, const std::int64_t start);
+
+// Times one call for as long as it lives. A null name is a no-op, which is
+// what every call is without a trace.
+class Span {
+public:
+    explicit Span(const Name* name): name(name), start(nullptr == name ? 0 : now()) { }
+
+    ~Span() {
+        if (nullptr != name) {
+            record(name, start);
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const Name* name;
+    std::int64_t start;
+};
+
+// `threshold` drops calls shorter than it, builtins are only traced on request
+void start(const std::chrono::nanoseconds threshold, const bool builtins, const std::size_t capacity = 1 << 18);
+
+// false if `path` could not be written
+bool write(const std::string& path);
+
+} // namespace Trace
+} // namespace Runtime
+} // namespace ELang
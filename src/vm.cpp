@@ -1,12 +1,77 @@
 #include "vm.hpp"
 #include "builtin.hpp"
+#include "pool.hpp"
+#include "infer.hpp"
+#include "output.hpp"
 #include "gen/parser.hpp"
 
+#include <algorithm>
+#include <chrono>
+
 using namespace ELang::Runtime;
 using namespace ELang::Meta;
 using namespace std;
 
+namespace {
+
+// whether `yield` appears in a function body, nested function declarations aside
+bool contains_yield(const Block* block) {
+    if (nullptr == block) {
+        return false;
+    }
+
+    for (const auto statement: block->statements) {
+        if (nullptr != dynamic_cast<const YieldStatement*>(statement)) {
+            return true;
+        }
+
+        const auto if_statement = dynamic_cast<const IfStatement*>(statement);
+        if (nullptr != if_statement && (contains_yield(if_statement->then_block) || contains_yield(if_statement->else_block))) {
+            return true;
+        }
+
+        const auto for_loop = dynamic_cast<const ForLoop*>(statement);
+        if (nullptr != for_loop && contains_yield(for_loop->block)) {
+            return true;
+        }
+
+        const auto while_loop = dynamic_cast<const WhileLoop*>(statement);
+        if (nullptr != while_loop && contains_yield(while_loop->block)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// the generator whose body the calling thread is currently running
+thread_local Generator* running_generator = nullptr;
+
+// what one variable adds to a frame: a map node, its links and the pair
+constexpr std::size_t variable_bytes = 4 * sizeof(void*) + sizeof(std::pair<const std::string, Value>);
+
+// What reading the steady clock twice costs, taken off every timed call. The
+// cheapest of many back-to-back reads, so subtracting it never overcorrects.
+std::chrono::nanoseconds clock_overhead() {
+    static const auto overhead = [] {
+        auto cheapest = std::chrono::nanoseconds::max();
+        for (auto i = 0; i < 1000; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            const auto end = std::chrono::steady_clock::now();
+            cheapest = std::min(cheapest, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start));
+        }
+
+        return cheapest;
+    }();
+
+    return overhead;
+}
+
+} // namespace
+
 Value Interpreter::eval_expression(const Expression& expression, const std::shared_ptr<Context>& context) {
+    Stats::count(expression);
+
     // check for expression types
     const auto expr_ptr = &expression;
 
@@ -58,85 +123,19 @@ Value Interpreter::eval_expression(const Expression& expression, const std::shar
     // binary expression
     const auto binary_expr = dynamic_cast<const BinaryExpression*>(expr_ptr);
     if (nullptr != binary_expr) {
-        auto identifier = Identifier();
-        const auto args = vector<Expression*>({&binary_expr->lhs, &binary_expr->rhs});
-
-        switch (binary_expr->op) {
-            case TAND:
-                identifier.name = "__and__";
-                break;
-            case TOR:
-                identifier.name = "__or__";
-                break;
-            default:
-                cerr << "Error: Invalid operator" << endl;
-                throw -1; 
-        }
-
-        const auto function_call = FunctionCall(identifier, args);
-        return call_function(&function_call, context);
+        return eval_operator(binary_expr->op, binary_expr->lhs, binary_expr->rhs, binary_expr->kernel, context);
     }
 
     // arithmetic expression
     const auto arithmetic_expr = dynamic_cast<const ArithmeticExpression*>(expr_ptr);
     if (nullptr != arithmetic_expr) {
-        auto identifier = Identifier();
-        const auto args = vector<Expression*>({&arithmetic_expr->lhs, &arithmetic_expr->rhs});
-
-        switch (arithmetic_expr->op) {
-            case TPLUS:
-                identifier.name = "__add__";
-                break;
-            case TMINUS:
-                identifier.name = "__sub__";
-                break;
-            case TMUL:
-                identifier.name = "__mul__";
-                break;
-            case TDIV:
-                identifier.name = "__div__";
-                break;
-            default:
-                cerr << "Error: Invalid operator" << endl;
-                throw -1; 
-        }
-
-        const auto function_call = FunctionCall(identifier, args);
-        return call_function(&function_call, context);
+        return eval_operator(arithmetic_expr->op, arithmetic_expr->lhs, arithmetic_expr->rhs, arithmetic_expr->kernel, context);
     }
 
     // comparison expression
     const auto comparison_expr = dynamic_cast<const ComparisonExpression*>(expr_ptr);
     if (nullptr != comparison_expr) {
-        auto identifier = Identifier();
-        const auto args = vector<Expression*>({&comparison_expr->lhs, &comparison_expr->rhs});
-
-        switch (comparison_expr->op) {
-            case TEQ:
-                identifier.name = "__eq__";
-                break;
-            case TNE:
-                identifier.name = "__ne__";
-                break;
-            case TGTE:
-                identifier.name = "__gte__";
-                break;
-            case TGT:
-                identifier.name = "__gt__";
-                break;
-            case TLTE:
-                identifier.name = "__lte__";
-                break;
-            case TLT:
-                identifier.name = "__lt__";
-                break;
-            default:
-                cerr << "Error: Invalid operator" << endl;
-                throw -1; 
-        }
-
-        const auto function_call = FunctionCall(identifier, args);
-        return call_function(&function_call, context);
+        return eval_operator(comparison_expr->op, comparison_expr->lhs, comparison_expr->rhs, comparison_expr->kernel, context);
     }
 
     // range
@@ -158,6 +157,21 @@ Value Interpreter::eval_expression(const Expression& expression, const std::shar
     // index
     const auto index_expr = dynamic_cast<const IndexExpression*>(expr_ptr);
     if (nullptr != index_expr) {
+        // `m[i, j]`
+        if (nullptr != index_expr->column_expression) {
+            const auto args = vector<Expression*>({&index_expr->identifier_expression, &index_expr->expression, index_expr->column_expression});
+            const auto function_call = FunctionCall(Identifier("__at__"), args);
+            return call_function(&function_call, context);
+        }
+
+        // `v[a:b]` slices `v` without materializing the range
+        const auto range_index = dynamic_cast<const RangeExpression*>(&index_expr->expression);
+        if (nullptr != range_index) {
+            const auto args = vector<Expression*>({&index_expr->identifier_expression, &range_index->start, &range_index->end});
+            const auto function_call = FunctionCall(Identifier("__slice__"), args);
+            return call_function(&function_call, context);
+        }
+
         const auto args = vector<Expression*>({&index_expr->identifier_expression, &index_expr->expression});
         const auto function_call = FunctionCall(Identifier("__at__"), args);
         return call_function(&function_call, context);
@@ -172,6 +186,18 @@ Value Interpreter::eval_expression(const Expression& expression, const std::shar
     // identifier
     const auto identifier_expr = dynamic_cast<const Identifier*>(expr_ptr);
     if (nullptr != identifier_expr) {
+        auto value = Value();
+        if (context->find_variable(identifier_expr->name, value)) {
+            return value;
+        }
+
+        // a bare function name evaluates to its overload set
+        auto methods = std::vector<std::shared_ptr<ELang::Runtime::Method>>();
+        context->locate_methods(methods, identifier_expr->name);
+        if (methods.size() > 0) {
+            return Value(make_shared<FunctionRef>(identifier_expr->name, methods, context));
+        }
+
         return context->read_variable(identifier_expr->name);
     }
 
@@ -179,7 +205,44 @@ Value Interpreter::eval_expression(const Expression& expression, const std::shar
     throw -1;
 }
 
+// `lhs op rhs`, through the kernel infer_types resolved it to when there is
+// one, else through the `__add__` & co. overloads
+Value Interpreter::eval_operator(const int op, Expression& lhs, Expression& rhs,
+                                 const Kernel kernel, const std::shared_ptr<Context>& context) {
+    const auto method = operator_method(op);
+    if (nullptr == method) {
+        cerr << "Error: Invalid operator" << endl;
+        throw -1;
+    }
+
+    if (nullptr != kernel) {
+        const auto lhs_value = eval_expression(lhs, context);
+        const auto rhs_value = eval_expression(rhs, context);
+
+        auto result = Value();
+        if (kernel(lhs_value, rhs_value, result)) {
+            Stats::count(Stats::Counter::Specialized);
+            return result;
+        }
+
+        // an operand was rebound to another type, the operands are evaluated already
+        Stats::count(Stats::Counter::Lookups);
+        auto methods = std::vector<std::shared_ptr<ELang::Runtime::Method>>();
+        context->locate_methods(methods, method);
+
+        auto values = vector<Value>({lhs_value, rhs_value});
+        return invoke(method, methods, values, context);
+    }
+
+    const auto identifier = Identifier(method);
+    const auto args = vector<Expression*>({&lhs, &rhs});
+
+    const auto function_call = FunctionCall(identifier, args);
+    return call_function(&function_call, context);
+}
+
 void Context::locate_methods(std::vector<std::shared_ptr<ELang::Runtime::Method>>& results, const std::string& name) const {
+    Stats::count(Stats::Counter::ScopesSearched);
     const auto fun = methods.find(name);
 
     if (fun != methods.end()) {
@@ -193,6 +256,7 @@ void Context::locate_methods(std::vector<std::shared_ptr<ELang::Runtime::Method>
 }
 
 Value Interpreter::call_function(const ELang::Meta::FunctionCall* expression, const std::shared_ptr<Context>& context) {
+    Stats::count(Stats::Counter::Lookups);
     auto methods = std::vector<std::shared_ptr<ELang::Runtime::Method>>();
     context->locate_methods(methods, expression->id.name);
 
@@ -202,15 +266,28 @@ Value Interpreter::call_function(const ELang::Meta::FunctionCall* expression, co
         expression_values.push_back(eval_expression(**it, context));
     }
 
+    // calling through a variable holding a function, e.g. `g = f; g(1)`
+    auto callee = Value();
+    if (methods.size() == 0 && context->find_variable(expression->id.name, callee) && callee.type == Type::Function) {
+        methods = std::get<shared_ptr<FunctionRef>>(callee.value)->methods;
+    }
+
+    return invoke(expression->id.name, methods, expression_values, context);
+}
+
+Value Interpreter::invoke(const std::string& name, const std::vector<std::shared_ptr<Method>>& methods, std::vector<Value>& expression_values, const std::shared_ptr<Context>& context) {
     if (methods.size() == 0) {
-        cerr << "Error: Unknown function `" << expression->id.name << "`" << endl;
+        Stats::count(Stats::Counter::LookupFailures);
+        cerr << "Error: Unknown function `" << name << "`" << endl;
         throw -1;
     }
 
     for (auto it = methods.cbegin(); it != methods.cend(); ++it) {       
         const auto ptr = *it;
+        Stats::count(Stats::Counter::OverloadsTried);
 
-        if (ptr->arguments.size() == expression_values.size()) {
+        const auto arity = ptr->arguments.size();
+        if (arity == expression_values.size() || (ptr->variadic && arity < expression_values.size())) {
             auto match = true;
 
             for (std::size_t i = 0; i < ptr->arguments.size(); ++i) {
@@ -220,24 +297,38 @@ Value Interpreter::call_function(const ELang::Meta::FunctionCall* expression, co
             if (match) {
                 const auto builtin = dynamic_pointer_cast<BuiltinMethod>(*it);
                 if (nullptr != builtin) {
+                    Stats::count(Stats::Counter::BuiltinCalls);
+                    const Trace::Span span(builtin->traced);
                     return builtin->callable(expression_values);
                 }
 
                 const auto custom = dynamic_pointer_cast<CustomMethod>(*it);
                 if (nullptr != custom) {
+                    Stats::count(Stats::Counter::CustomCalls);
+
                     // todo: function needs to return the last evaluated expression
                     const auto block_context = make_shared<Context>(context);
 
                     for (std::size_t i = 0; i < ptr->arguments.size(); ++i) {
                         block_context->assign_variable(ptr->arguments[i].name, expression_values[i], true);
                     }
-                    
+
+                    // generator bodies resume inside their consumer's frame
+                    if (custom->generator) {
+                        return Value(make_shared<Generator>(name, [this, custom, block_context] {
+                            run(custom->block, block_context);
+                        }));
+                    }
+
+                    const Profile::Frame frame(custom->profile);
+                    const Trace::Span span(custom->traced);
                     return run(custom->block, block_context);
                 }
             }
         }
     }
 
+    Stats::count(Stats::Counter::LookupFailures);
     cerr << "Error: Method not found" << endl;
     throw -1;
 }
@@ -248,6 +339,14 @@ Value Interpreter::run(const Block* program, const std::shared_ptr<Context>& con
     for (auto it = program->statements.cbegin(); it != program->statements.cend(); ++it) {
         const auto statement = *it;
 
+        Stats::count(*statement);
+        if (Profile::active()) {
+            Profile::line(statement->line);
+        }
+        if (Memory::active()) {
+            Memory::line(statement->line);
+        }
+
         // check for statement types
 
         const auto if_statement = dynamic_cast<IfStatement*>(statement);
@@ -295,16 +394,39 @@ Value Interpreter::run(const Block* program, const std::shared_ptr<Context>& con
             continue;
         }
 
+        // before ForLoop, which it derives from
+        const auto parallel_loop = dynamic_cast<ParallelForLoop*>(statement);
+        if (nullptr != parallel_loop) {
+            run_parallel_for(parallel_loop, context);
+
+            last_evaluated_value = Value();
+            continue;
+        }
+
         const auto for_loop = dynamic_cast<ForLoop*>(statement);
         if (nullptr != for_loop) {
             const auto iterator = eval_expression(for_loop->iterator, context);
+            if (iterator.type == Type::Generator) {
+                // pull one value at a time, the generator runs up to its next yield
+                const auto generator = std::get<shared_ptr<Generator>>(iterator.value);
+                auto element = Value();
+
+                while (generator->next(element)) {
+                    context->assign_variable(for_loop->id.name, element);
+                    last_evaluated_value = run(for_loop->block, context);
+                }
+                continue;
+            }
+
             if (iterator.type != Type::Vector) {
                 cerr << "Invalid iterator." << endl;
                 throw -1;
             }
 
-            const auto iterator_value = std::get<shared_ptr<vector<Value>>>(iterator.value);
-            for (auto it = iterator_value->cbegin(); it != iterator_value->cend(); ++it) {
+            // iterate over a pinned copy of the window: pushing into the iterated
+            // vector from the loop body detaches it instead of invalidating `it`
+            const auto iterator_value = *std::get<shared_ptr<VectorSlice>>(iterator.value);
+            for (auto it = iterator_value.begin(); it != iterator_value.end(); ++it) {
                 context->assign_variable(for_loop->id.name, *it);
                 last_evaluated_value = run(for_loop->block, context);
             }
@@ -322,12 +444,20 @@ Value Interpreter::run(const Block* program, const std::shared_ptr<Context>& con
                 args.push_back(Argument(param->id.name, type));
             }
 
-            context->register_method(shared_ptr<Method>(new CustomMethod(func_decl->id.name, args, func_decl->block)));
+            context->register_method(shared_ptr<Method>(new CustomMethod(func_decl->id.name, args, func_decl->block, contains_yield(func_decl->block))));
 
             last_evaluated_value = Value();
             continue;
         }
         
+        const auto yield_statement = dynamic_cast<YieldStatement*>(statement);
+        if (nullptr != yield_statement) {
+            Generator::yield(eval_expression(yield_statement->expression, context));
+
+            last_evaluated_value = Value();
+            continue;
+        }
+
         const auto assignment = dynamic_cast<Assignment*>(statement);
         if (nullptr != assignment) {
             const auto value = eval_expression(assignment->expression, context);
@@ -366,6 +496,27 @@ Type Interpreter::get_type_from_identifier(const std::string& identifier) const
     else if (identifier == "Vector") {
         return Type::Vector;
     }
+    else if (identifier == "String") {
+        return Type::String;
+    }
+    else if (identifier == "Function") {
+        return Type::Function;
+    }
+    else if (identifier == "Matrix") {
+        return Type::Matrix;
+    }
+    else if (identifier == "Mask") {
+        return Type::Mask;
+    }
+    else if (identifier == "Task") {
+        return Type::Task;
+    }
+    else if (identifier == "Generator") {
+        return Type::Generator;
+    }
+    else if (identifier == "File") {
+        return Type::File;
+    }
     else {
         cerr << "Invalid type: `" << identifier << "`" << endl;
         throw -1;
@@ -377,6 +528,535 @@ void Interpreter::print_value(const Value& v) const {
     builtin_show({v});
 }
 
+std::shared_ptr<Context> Interpreter::isolated_frame(const FunctionRef& function) {
+    auto parent = function.context.lock();
+    if (nullptr == parent) {
+        // the frame the name was evaluated in is gone
+        parent = global_context;
+    }
+
+    const auto frame = make_shared<Context>(parent);
+    frame->isolated = true;
+    return frame;
+}
+
+// map/filter/reduce split large vectors across the thread pool. Every chunk
+// calls `f` below its own isolated frame: outer variables and methods can be
+// read but not reassigned. Values reachable from outer frames are still
+// shared, so `f` must not push!/pop! them.
+
+Value Interpreter::builtin_map(const std::vector<Value>& params) {
+    if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
+        throw -1;
+    }
+
+    const auto fun = params.at(0);
+    const auto vec = params.at(1);
+
+    if (fun.type == Type::Function && vec.type == Type::Vector) {
+        const auto funval = std::get<shared_ptr<FunctionRef>>(fun.value);
+        const auto vecval = *std::get<shared_ptr<VectorSlice>>(vec.value);
+        const auto result = make_shared<vector<Value>>(vecval.length);
+
+        const auto capture = current_capture();
+        ThreadPool::instance().run(vecval.length, [&](std::size_t begin, std::size_t end) {
+            const CaptureScope scope(capture);
+            const auto frame = isolated_frame(*funval);
+            auto args = vector<Value>(1);
+
+            for (auto i = begin; i < end; ++i) {
+                args[0] = vecval.at(i);
+                (*result)[i] = invoke(funval->name, funval->methods, args, frame);
+            }
+        });
+
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value Interpreter::builtin_filter(const std::vector<Value>& params) {
+    if (params.size() != 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 2" << std::endl;
+        throw -1;
+    }
+
+    const auto fun = params.at(0);
+    const auto vec = params.at(1);
+
+    if (fun.type == Type::Function && vec.type == Type::Vector) {
+        const auto funval = std::get<shared_ptr<FunctionRef>>(fun.value);
+        const auto vecval = *std::get<shared_ptr<VectorSlice>>(vec.value);
+        auto keep = vector<char>(vecval.length);
+
+        const auto capture = current_capture();
+        ThreadPool::instance().run(vecval.length, [&](std::size_t begin, std::size_t end) {
+            const CaptureScope scope(capture);
+            const auto frame = isolated_frame(*funval);
+            auto args = vector<Value>(1);
+
+            for (auto i = begin; i < end; ++i) {
+                args[0] = vecval.at(i);
+                const auto res = invoke(funval->name, funval->methods, args, frame);
+
+                if (res.type != Type::Boolean) {
+                    cerr << "Invalid type for filter predicate." << endl;
+                    throw -1;
+                }
+
+                keep[i] = std::get<bool>(res.value);
+            }
+        });
+
+        const auto result = make_shared<vector<Value>>();
+        for (std::size_t i = 0; i < vecval.length; ++i) {
+            if (keep[i]) {
+                result->push_back(vecval.at(i));
+            }
+        }
+
+        return Value(result);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value Interpreter::builtin_reduce(const std::vector<Value>& params) {
+    if (params.size() != 3) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 3" << std::endl;
+        throw -1;
+    }
+
+    const auto fun = params.at(0);
+    const auto vec = params.at(1);
+    const auto init = params.at(2);
+
+    if (fun.type == Type::Function && vec.type == Type::Vector) {
+        const auto funval = std::get<shared_ptr<FunctionRef>>(fun.value);
+        const auto vecval = *std::get<shared_ptr<VectorSlice>>(vec.value);
+
+        // chunks are folded independently and then combined left to right, so
+        // `f` has to be associative for the result not to depend on the split
+        auto partials = map<std::size_t, Value>();
+        std::mutex partials_mutex;
+
+        const auto capture = current_capture();
+        ThreadPool::instance().run(vecval.length, [&](std::size_t begin, std::size_t end) {
+            const CaptureScope scope(capture);
+            const auto frame = isolated_frame(*funval);
+            auto args = vector<Value>(2);
+            const auto first = begin;
+            auto acc = begin == 0 ? init : vecval.at(begin++);
+
+            for (auto i = begin; i < end; ++i) {
+                args[0] = acc;
+                args[1] = vecval.at(i);
+                acc = invoke(funval->name, funval->methods, args, frame);
+            }
+
+            std::lock_guard<std::mutex> lock(partials_mutex);
+            partials[first] = acc;
+        });
+
+        const auto frame = isolated_frame(*funval);
+        auto args = vector<Value>(2);
+        auto it = partials.cbegin();
+        auto acc = it->second;
+
+        for (++it; it != partials.cend(); ++it) {
+            args[0] = acc;
+            args[1] = it->second;
+            acc = invoke(funval->name, funval->methods, args, frame);
+        }
+
+        return acc;
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+// `parallel for` splits the iterated vector into one chunk per thread. Every
+// chunk runs below an isolated frame holding its own loop variable, its own
+// locals and a private copy of each reduction variable; nothing else it
+// assigns survives the loop. Private copies are merged in iteration order:
+//   sum   chunks after the first start from zero, results are added with `+`
+//   min   every chunk starts from the outer value, results are kept with `<`
+//   max   likewise, with `>`
+//   push  chunks start from an empty vector, results are appended in order
+
+void Interpreter::run_parallel_for(const ParallelForLoop* loop, const std::shared_ptr<Context>& context) {
+    const auto iterator = eval_expression(loop->iterator, context);
+    if (iterator.type != Type::Vector) {
+        cerr << "Invalid iterator." << endl;
+        throw -1;
+    }
+
+    auto initial = vector<Value>();
+    for (const auto reduction: loop->reductions) {
+        const auto& operation = reduction->operation.name;
+        if (operation != "sum" && operation != "min" && operation != "max" && operation != "push") {
+            cerr << "Invalid reduction: `" << operation << "`" << endl;
+            throw -1;
+        }
+
+        const auto value = context->read_variable(reduction->id.name);
+        if (operation == "push" && value.type != Type::Vector) {
+            cerr << "Invalid type for push reduction." << endl;
+            throw -1;
+        }
+        if (operation == "sum" && value.type != Type::Integer && value.type != Type::Float) {
+            cerr << "Invalid type for sum reduction." << endl;
+            throw -1;
+        }
+
+        initial.push_back(value);
+    }
+
+    const auto iterator_value = *std::get<shared_ptr<VectorSlice>>(iterator.value);
+    auto partials = map<std::size_t, vector<Value>>();
+    std::mutex partials_mutex;
+
+    const auto capture = current_capture();
+    ThreadPool::instance().run(iterator_value.length, [&](std::size_t begin, std::size_t end) {
+        const CaptureScope scope(capture);
+        const auto frame = make_shared<Context>(context);
+        frame->isolated = true;
+
+        for (std::size_t r = 0; r < loop->reductions.size(); ++r) {
+            const auto& operation = loop->reductions[r]->operation.name;
+            auto start = initial[r];
+
+            if (operation == "push") {
+                start = Value(make_shared<vector<Value>>());
+            }
+            else if (operation == "sum" && begin != 0) {
+                start = initial[r].type == Type::Integer ? Value(0L) : Value(0.0);
+            }
+
+            frame->assign_variable(loop->reductions[r]->id.name, start, true);
+        }
+
+        for (auto i = begin; i < end; ++i) {
+            frame->assign_variable(loop->id.name, iterator_value.at(i), true);
+            run(loop->block, frame);
+        }
+
+        auto results = vector<Value>();
+        for (const auto reduction: loop->reductions) {
+            results.push_back(frame->read_variable(reduction->id.name));
+        }
+
+        std::lock_guard<std::mutex> lock(partials_mutex);
+        partials[begin] = results;
+    }, 1);
+
+    for (std::size_t r = 0; r < loop->reductions.size(); ++r) {
+        const auto& operation = loop->reductions[r]->operation.name;
+        const auto& name = loop->reductions[r]->id.name;
+
+        if (operation == "push") {
+            // append into the vector itself, so every alias of it sees the elements
+            const auto target = std::get<shared_ptr<VectorSlice>>(initial[r].value);
+            for (const auto& partial: partials) {
+                const auto pushed = partial.second[r];
+                if (pushed.type != Type::Vector) {
+                    cerr << "Invalid type for push reduction." << endl;
+                    throw -1;
+                }
+
+                for (const auto& element: *std::get<shared_ptr<VectorSlice>>(pushed.value)) {
+                    target->push_back(element);
+                }
+            }
+
+            continue;
+        }
+
+        const auto combine = operation == "sum" ? "__add__" : (operation == "min" ? "__lt__" : "__gt__");
+        auto methods = vector<shared_ptr<Method>>();
+        context->locate_methods(methods, combine);
+
+        auto it = partials.cbegin();
+        auto acc = it->second[r];
+        auto args = vector<Value>(2);
+
+        for (++it; it != partials.cend(); ++it) {
+            const auto partial = it->second[r];
+
+            if (operation == "sum") {
+                args[0] = acc;
+                args[1] = partial;
+                acc = invoke(combine, methods, args, context);
+                continue;
+            }
+
+            args[0] = partial;
+            args[1] = acc;
+            const auto better = invoke(combine, methods, args, context);
+            if (better.type != Type::Boolean) {
+                cerr << "Invalid type for " << operation << " reduction." << endl;
+                throw -1;
+            }
+
+            if (std::get<bool>(better.value)) {
+                acc = partial;
+            }
+        }
+
+        context->assign_variable(name, acc);
+    }
+}
+
+// Tasks run on the work-stealing pool below an isolated frame of their own.
+// What a task sees: its arguments, plus the script's top-level scope
+// (functions and variables) as it was when the task was spawned. That is the
+// global context when it runs the script directly, or the frame right below it
+// when it is shared by several runs (see Engine). The spawner's locals are not
+// visible and assignments made inside the task stay inside it. As with map,
+// vectors passed in are shared, so tasks must not push!/pop! them.
+
+std::shared_ptr<Context> Interpreter::task_scope(const FunctionRef& function) {
+    auto scope = function.context.lock();
+    if (nullptr == scope) {
+        scope = global_context;
+    }
+
+    while (!scope->frozen && nullptr != scope->parent && scope->parent != global_context) {
+        scope = scope->parent;
+    }
+
+    // spawned from inside a task: nested tasks share the same snapshot
+    if (scope->frozen) {
+        return scope;
+    }
+
+    std::lock_guard<std::mutex> lock(snapshot_mutex);
+    if (nullptr == task_snapshot || task_snapshot_source.lock() != scope || task_snapshot_version != scope->version) {
+        task_snapshot = make_shared<Context>(scope == global_context ? nullptr : global_context);
+        task_snapshot->methods = scope->methods;
+        task_snapshot->variables = scope->variables;
+        task_snapshot->frozen = true;
+        task_snapshot_source = scope;
+        task_snapshot_version = scope->version;
+    }
+
+    return task_snapshot;
+}
+
+bool Generator::next(Value& value) {
+    if (nullptr == coroutine) {
+        return pull(value);
+    }
+
+    const auto previous = running_generator;
+    running_generator = this;
+
+    auto more = false;
+    try {
+        more = coroutine->resume();
+    }
+    catch (...) {
+        running_generator = previous;
+        throw;
+    }
+
+    running_generator = previous;
+    if (more) {
+        value = yielded;
+    }
+
+    return more;
+}
+
+void Generator::yield(const Value& value) {
+    const auto generator = running_generator;
+    if (nullptr == generator) {
+        cerr << "Error: yield outside of a generator" << endl;
+        throw -1;
+    }
+
+    generator->yielded = value;
+    Coroutine::suspend();
+}
+
+void Task::execute() {
+    try {
+        result = body();
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+
+    // drop the captured arguments and frame as soon as possible
+    body = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+    }
+
+    done.notify_all();
+}
+
+Value Interpreter::builtin_spawn(const std::vector<Value>& params) {
+    if (params.size() < 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected at least 1" << std::endl;
+        throw -1;
+    }
+
+    const auto fun = params.at(0);
+
+    if (fun.type == Type::Function) {
+        const auto funval = std::get<shared_ptr<FunctionRef>>(fun.value);
+        const auto args = vector<Value>(params.cbegin() + 1, params.cend());
+        const auto frame = make_shared<Context>(task_scope(*funval));
+        frame->isolated = true;
+
+        const auto capture = current_capture();
+        const auto task = make_shared<Task>([this, funval, args, frame, capture]() {
+            const CaptureScope scope(capture);
+            auto values = args;
+            return invoke(funval->name, funval->methods, values, frame);
+        });
+
+        ++pending_tasks;
+        ThreadPool::instance().submit([this, task] {
+            if (task->claim()) {
+                task->execute();
+                --pending_tasks;
+            }
+        });
+
+        return Value(task);
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+Value Interpreter::builtin_fetch(const std::vector<Value>& params) {
+    if (params.size() != 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected 1" << std::endl;
+        throw -1;
+    }
+
+    const auto val = params.at(0);
+
+    if (val.type == Type::Task) {
+        const auto task = std::get<shared_ptr<Task>>(val.value);
+
+        // nobody picked it up yet: cheaper to run it right here
+        if (task->claim()) {
+            task->execute();
+            --pending_tasks;
+        }
+
+        // otherwise keep the pool busy until whoever runs it is done
+        while (!task->finished) {
+            if (!ThreadPool::instance().help()) {
+                std::unique_lock<std::mutex> lock(task->mutex);
+                task->done.wait_for(lock, std::chrono::milliseconds(1), [&task] { return task->finished.load(); });
+            }
+        }
+
+        if (task->error) {
+            std::rethrow_exception(task->error);
+        }
+
+        return task->result;
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+// elapsed and benchmark call `f` on the calling thread, in the scope its name
+// was evaluated in, as a direct call would. Times are nanoseconds on the
+// steady clock, less the clock's own overhead.
+
+Value Interpreter::builtin_elapsed(const std::vector<Value>& params) {
+    if (params.size() < 1) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected at least 1" << std::endl;
+        throw -1;
+    }
+
+    const auto fun = params.at(0);
+
+    if (fun.type == Type::Function) {
+        const auto funval = std::get<shared_ptr<FunctionRef>>(fun.value);
+        const auto scope = funval->context.lock();
+        auto args = vector<Value>(params.cbegin() + 1, params.cend());
+
+        const auto start = std::chrono::steady_clock::now();
+        invoke(funval->name, funval->methods, args, nullptr == scope ? global_context : scope);
+        const auto end = std::chrono::steady_clock::now();
+
+        const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start) - clock_overhead();
+        return Value(static_cast<long>(std::max(0L, static_cast<long>(duration.count()))));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
+// `benchmark(f, args..., n)` is [min, median, p99] over n timed calls
+Value Interpreter::builtin_benchmark(const std::vector<Value>& params) {
+    if (params.size() < 2) {
+        std::cerr << "Invalid parameter count. Found " << params.size() << ". Expected at least 2" << std::endl;
+        throw -1;
+    }
+
+    const auto fun = params.front();
+    const auto count = params.back();
+
+    if (fun.type == Type::Function && count.type == Type::Integer && std::get<long>(count.value) > 0) {
+        const auto funval = std::get<shared_ptr<FunctionRef>>(fun.value);
+        const auto found = funval->context.lock();
+        const auto scope = nullptr == found ? global_context : found;
+        const auto args = vector<Value>(params.cbegin() + 1, params.cend() - 1);
+        const auto n = static_cast<std::size_t>(std::get<long>(count.value));
+        const auto overhead = clock_overhead();
+
+        // a tenth of the runs untimed first, for caches and lazily built state
+        for (std::size_t i = 0; i < std::max<std::size_t>(1, n / 10); ++i) {
+            auto values = args;
+            invoke(funval->name, funval->methods, values, scope);
+        }
+
+        auto samples = vector<long>(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            auto values = args;
+
+            const auto start = std::chrono::steady_clock::now();
+            invoke(funval->name, funval->methods, values, scope);
+            const auto end = std::chrono::steady_clock::now();
+
+            const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start) - overhead;
+            samples[i] = std::max(0L, static_cast<long>(duration.count()));
+        }
+
+        std::sort(samples.begin(), samples.end());
+        const auto p99 = (n * 99 + 99) / 100 - 1;
+
+        return Value(make_shared<vector<Value>>(vector<Value>({ Value(samples.front()), Value(samples[(n - 1) / 2]), Value(samples[p99]) })));
+    }
+    else {
+        std::cerr << "Invalid parameter types" << std::endl;
+        throw -1;
+    }
+}
+
 void Interpreter::register_builtins() {
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__add__", { Argument("lhs", Type::Integer), Argument("rhs", Type::Integer) }, builtin_add)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__add__", { Argument("lhs", Type::Float), Argument("rhs", Type::Integer) }, builtin_add)));
@@ -451,19 +1131,120 @@ void Interpreter::register_builtins() {
 
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__at__", { Argument("vec", Type::Vector), Argument("index", Type::Integer) }, builtin_at)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__in__", { Argument("vec", Type::Vector), Argument("value", Type::Any) }, builtin_in)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__slice__", { Argument("vec", Type::Vector), Argument("first", Type::Integer), Argument("last", Type::Integer) }, builtin_slice)));
 
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("show", { Argument("value", Type::Any) }, builtin_show)));
 
+    // output
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("print", { Argument("value", Type::Any) }, builtin_print, true)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("println", { }, builtin_println)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("println", { Argument("value", Type::Any) }, builtin_println, true)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("flush", { }, builtin_flush)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("buffering", { Argument("mode", Type::String) }, builtin_buffering)));
+
+    // files
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("open", { Argument("path", Type::String) }, builtin_open)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("open", { Argument("path", Type::String), Argument("mode", Type::String) }, builtin_open)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("read", { Argument("path", Type::String) }, builtin_read)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("read", { Argument("file", Type::File) }, builtin_read)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("readlines", { Argument("path", Type::String) }, builtin_readlines)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("readlines", { Argument("file", Type::File) }, builtin_readlines)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("write", { Argument("file", Type::File), Argument("value", Type::Any) }, builtin_write, true)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("writeln", { Argument("file", Type::File) }, builtin_writeln)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("writeln", { Argument("file", Type::File), Argument("value", Type::Any) }, builtin_writeln, true)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("flush", { Argument("file", Type::File) }, builtin_flush)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("close", { Argument("file", Type::File) }, builtin_close)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("readnumbers", { Argument("path", Type::String) }, builtin_readnumbers)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("readnumbers", { Argument("file", Type::File) }, builtin_readnumbers)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("readcsv", { Argument("path", Type::String) }, builtin_readcsv)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("readcsv", { Argument("file", Type::File) }, builtin_readcsv)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("readcsv", { Argument("path", Type::String), Argument("sep", Type::String) }, builtin_readcsv)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("readcsv", { Argument("file", Type::File), Argument("sep", Type::String) }, builtin_readcsv)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("save", { Argument("path", Type::String), Argument("value", Type::Any) }, builtin_save)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("load", { Argument("path", Type::String) }, builtin_load)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("attach", { Argument("path", Type::String), Argument("type", Type::String) }, builtin_attach)));
+
+    // runtime
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("memstats", { }, builtin_memstats)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("memstats", { Argument("category", Type::String) }, builtin_memstats)));
+
+    // masks
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("mask", { Argument("vec", Type::Vector) }, builtin_mask)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("count", { Argument("mask", Type::Mask) }, builtin_count)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("any", { Argument("mask", Type::Mask) }, builtin_any)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("all", { Argument("mask", Type::Mask) }, builtin_all)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("length", { Argument("mask", Type::Mask) }, builtin_length)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__not__", { Argument("expr", Type::Mask) }, builtin_not)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__and__", { Argument("lhs", Type::Mask), Argument("rhs", Type::Mask) }, builtin_and)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__or__", { Argument("lhs", Type::Mask), Argument("rhs", Type::Mask) }, builtin_or)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__at__", { Argument("vec", Type::Vector), Argument("mask", Type::Mask) }, builtin_at)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__eq__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Integer) }, builtin_eq)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__eq__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Float) }, builtin_eq)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__ne__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Integer) }, builtin_ne)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__ne__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Float) }, builtin_ne)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__gte__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Integer) }, builtin_gte)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__gte__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Float) }, builtin_gte)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__gt__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Integer) }, builtin_gt)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__gt__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Float) }, builtin_gt)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__lte__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Integer) }, builtin_lte)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__lte__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Float) }, builtin_lte)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__lt__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Integer) }, builtin_lt)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__lt__", { Argument("lhs", Type::Vector), Argument("rhs", Type::Float) }, builtin_lt)));
+
+    // matrix functions
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("zeros", { Argument("rows", Type::Integer), Argument("cols", Type::Integer) }, builtin_zeros)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("ones", { Argument("rows", Type::Integer), Argument("cols", Type::Integer) }, builtin_ones)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("matrix", { Argument("rows", Type::Vector) }, builtin_matrix)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("rows", { Argument("mat", Type::Matrix) }, builtin_rows)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("cols", { Argument("mat", Type::Matrix) }, builtin_cols)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__at__", { Argument("mat", Type::Matrix), Argument("row", Type::Integer), Argument("col", Type::Integer) }, builtin_at)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("set!", { Argument("mat", Type::Matrix), Argument("row", Type::Integer), Argument("col", Type::Integer), Argument("value", Type::Any) }, builtin_set_bang)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("matmul", { Argument("lhs", Type::Matrix), Argument("rhs", Type::Matrix) }, builtin_matmul)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("transpose", { Argument("mat", Type::Matrix) }, builtin_transpose)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("rowsum", { Argument("mat", Type::Matrix) }, builtin_rowsum)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("colsum", { Argument("mat", Type::Matrix) }, builtin_colsum)));
+
+    // higher order functions
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("map", { Argument("f", Type::Function), Argument("vec", Type::Vector) },
+        [this](std::vector<Value>& params) { return builtin_map(params); })));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("filter", { Argument("f", Type::Function), Argument("vec", Type::Vector) },
+        [this](std::vector<Value>& params) { return builtin_filter(params); })));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("reduce", { Argument("f", Type::Function), Argument("vec", Type::Vector), Argument("init", Type::Any) },
+        [this](std::vector<Value>& params) { return builtin_reduce(params); })));
+
+    // generators
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("collect", { Argument("gen", Type::Generator) }, builtin_collect)));
+
+    // tasks
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("spawn", { Argument("f", Type::Function) },
+        [this](std::vector<Value>& params) { return builtin_spawn(params); }, true)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("fetch", { Argument("task", Type::Task) },
+        [this](std::vector<Value>& params) { return builtin_fetch(params); })));
+
+    // timing
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("time_ns", { }, builtin_time_ns)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("elapsed", { Argument("f", Type::Function) },
+        [this](std::vector<Value>& params) { return builtin_elapsed(params); }, true)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("benchmark", { Argument("f", Type::Function) },
+        [this](std::vector<Value>& params) { return builtin_benchmark(params); }, true)));
+
     // string functions
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__add__", { Argument("lhs", Type::String), Argument("rhs", Type::String) }, builtin_add)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__eq__", { Argument("lhs", Type::String), Argument("rhs", Type::String) }, builtin_eq)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__ne__", { Argument("lhs", Type::String), Argument("rhs", Type::String) }, builtin_ne)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__at__", { Argument("str", Type::String), Argument("index", Type::Integer) }, builtin_at)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("__slice__", { Argument("str", Type::String), Argument("first", Type::Integer), Argument("last", Type::Integer) }, builtin_slice)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("length", { Argument("vec", Type::String) }, builtin_length)));
 
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("substr", { Argument("str", Type::String), Argument("length", Type::Integer) }, builtin_substr)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("substr", { Argument("str", Type::String), Argument("start", Type::Integer), Argument("length", Type::Integer) }, builtin_substr)));
 
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("find", { Argument("str", Type::String), Argument("sub", Type::String) }, builtin_find)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("find", { Argument("str", Type::String), Argument("sub", Type::String), Argument("start", Type::Integer) }, builtin_find)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("contains", { Argument("str", Type::String), Argument("sub", Type::String) }, builtin_contains)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("startswith", { Argument("str", Type::String), Argument("prefix", Type::String) }, builtin_startswith)));
+    global_context->register_method(shared_ptr<Method>(new BuiltinMethod("replace", { Argument("str", Type::String), Argument("old", Type::String), Argument("new", Type::String) }, builtin_replace)));
+
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("lower", { Argument("str", Type::String) }, builtin_lower)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("upper", { Argument("str", Type::String) }, builtin_upper)));
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("lower!", { Argument("str", Type::String) }, builtin_lower_bang)));
@@ -473,10 +1254,23 @@ void Interpreter::register_builtins() {
     global_context->register_method(shared_ptr<Method>(new BuiltinMethod("split", { Argument("str", Type::String), Argument("sep", Type::String) }, builtin_split)));
 }
 
-Interpreter::Interpreter() {
+Interpreter::Interpreter(): pending_tasks(0), task_snapshot_version(0) {
     global_context = std::make_shared<Context>();
 }
 
+Interpreter::~Interpreter() {
+    wait_for_tasks();
+}
+
+void Interpreter::wait_for_tasks() {
+    // tasks nobody fetched still run to completion
+    while (pending_tasks > 0) {
+        if (!ThreadPool::instance().help()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
 void Context::register_method(const std::shared_ptr<Method>& method) {
     const auto it = methods.find(method->identifier);
     if (it == methods.end()) {
@@ -485,45 +1279,101 @@ void Context::register_method(const std::shared_ptr<Method>& method) {
 
     // TODO: collisions. what if we already have a method with the same arguments?
     methods[method->identifier].push_back(method);
+    ++version;
 }
 
 void Context::assign_variable(const string& name, const Value& value, bool force_local) {
     // TODO: context disambiguation. i.e. local/global keywords
-    auto search_context = this;
-    auto variable_exists = false;
-
     if (force_local) {
         variables[name] = value;
+        ++version;
+        charge.resize(sizeof(Context) + variables.size() * variable_bytes);
         return;
     }
 
-    while (nullptr != search_context && !variable_exists) {
+    for (auto search_context = this; nullptr != search_context; search_context = search_context->parent.get()) {
         const auto it = search_context->variables.find(name);
-        if (it == search_context->variables.end()) {
-            search_context = search_context->parent.get();
+        if (it != search_context->variables.end()) {
+            it->second = value;
+            ++search_context->version;
+            return;
         }
-        else {
-            variable_exists = true;
-            search_context->variables[name] = value;
+
+        if (search_context->isolated) {
+            break;
         }
     }
 
-    if (!variable_exists) {
-        variables[name] = value;
-    }
+    variables[name] = value;
+    ++version;
+    charge.resize(sizeof(Context) + variables.size() * variable_bytes);
+}
+
+void VectorSlice::push_back(const Value& value) {
+    auto& elements = detach();
+
+    elements.push_back(value);
+    ++length;
+    charge.resize(elements.capacity() * sizeof(Value));
 }
 
-Value Context::read_variable(const string& name) {
-    const auto it = variables.find(name);
-    if (it == variables.end()) {
-        if (nullptr != parent) {
-            return parent->read_variable(name);
+Value VectorSlice::pop_back() {
+    auto& elements = detach();
+    const auto last = elements.back();
+
+    elements.pop_back();
+    --length;
+    return last;
+}
+
+std::vector<Value>& VectorSlice::detach() {
+    // copy the window out unless this slice already owns the whole storage alone
+    if (nullptr != mapping || storage.use_count() > 1 || offset != 0 || length != storage->size()) {
+        const auto elements = std::make_shared<std::vector<Value>>();
+        elements->reserve(length);
+        for (std::size_t i = 0; i < length; ++i) {
+            elements->push_back(at(i));
         }
-        else {
-            cerr << "Calling variable `" << name << "` before assignment." << endl;
-            throw -1;
+
+        storage = elements;
+        mapping = nullptr;
+        offset = 0;
+        charge.resize(elements->capacity() * sizeof(Value));
+    }
+
+    return *storage;
+}
+
+std::string& StringSlice::detach() {
+    // copy the window out unless this slice already owns the whole buffer alone
+    if (nullptr != mapping || storage.use_count() > 1 || offset != 0 || length != storage->length()) {
+        storage = std::make_shared<std::string>(view());
+        mapping = nullptr;
+        offset = 0;
+        charge.resize(storage->capacity());
+    }
+
+    return *storage;
+}
+
+bool Context::find_variable(const string& name, Value& value) const {
+    for (auto search_context = this; nullptr != search_context; search_context = search_context->parent.get()) {
+        const auto it = search_context->variables.find(name);
+        if (it != search_context->variables.end()) {
+            value = it->second;
+            return true;
         }
     }
 
-    return variables[name];
+    return false;
+}
+
+Value Context::read_variable(const string& name) const {
+    auto value = Value();
+    if (!find_variable(name, value)) {
+        cerr << "Calling variable `" << name << "` before assignment." << endl;
+        throw -1;
+    }
+
+    return value;
 }
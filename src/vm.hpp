@@ -1,25 +1,54 @@
 #pragma once
 
 #include "elang.hpp"
+#include "matrix.hpp"
+#include "mask.hpp"
+#include "coroutine.hpp"
+#include "mapped.hpp"
+#include "memory.hpp"
+#include "profile.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <variant>
 #include <map>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <memory>
 #include <vector>
+#include <stdexcept>
 
 
 namespace ELang {
 namespace Runtime {
 
 class Value; // forward declaration
+class VectorSlice;
+class StringSlice;
+class FunctionRef;
+class Task;
+class Generator;
+class File;
 
 typedef std::variant<std::monostate,
                      long,
                      double,
                      bool,
-                     std::shared_ptr<std::vector<Value>>,
-                     std::shared_ptr<std::string>> Variant;
+                     std::shared_ptr<VectorSlice>,
+                     std::shared_ptr<StringSlice>,
+                     std::shared_ptr<FunctionRef>,
+                     std::shared_ptr<Matrix>,
+                     std::shared_ptr<Mask>,
+                     std::shared_ptr<Task>,
+                     std::shared_ptr<Generator>,
+                     std::shared_ptr<File>> Variant;
 
 enum class Type {
     Void,
@@ -29,16 +58,115 @@ enum class Type {
     Boolean,
     Vector,
     String,
+    Function,
+    Matrix,
+    Mask,
+    Task,
+    Generator,
+    File,
 };
 
 
+// A window over shared element storage. Plain vectors are slices covering
+// their whole storage; `v[a:b]` hands out slices into `v`. Whichever side
+// mutates first through push!/pop! copies its window out (copy-on-write).
+// Attached vectors have no storage: their elements are raw 64-bit numbers read
+// straight from a mapped file, which nothing ever writes to.
+class VectorSlice {
+public:
+    // elements by value, attached vectors have no Values to point at
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Value*;
+        using reference = Value;
+
+        Iterator(const VectorSlice* slice, const std::size_t index): slice(slice), index(index) { }
+
+        inline Value operator*() const;
+        inline Iterator& operator++() { ++index; return *this; }
+        inline Iterator operator++(int) { auto previous = *this; ++index; return previous; }
+        inline bool operator==(const Iterator& other) const { return index == other.index; }
+        inline bool operator!=(const Iterator& other) const { return index != other.index; }
+
+    private:
+        const VectorSlice* slice;
+        std::size_t index;
+    };
+
+    std::shared_ptr<std::vector<Value>> storage;
+    std::shared_ptr<const MappedFile> mapping;
+    Type element;
+    std::size_t offset;
+    std::size_t length;
+
+    // the storage this slice created, windows into other storage hold none
+    Memory::Charge charge{Memory::Category::Vector};
+
+    VectorSlice(const std::shared_ptr<std::vector<Value>>& storage);
+    VectorSlice(const std::shared_ptr<std::vector<Value>>& storage, std::size_t offset, std::size_t length);
+    VectorSlice(const std::shared_ptr<const MappedFile>& mapping, const Type element);
+
+    // a window into `source`, sharing whatever backs it
+    VectorSlice(const VectorSlice& source, std::size_t offset, std::size_t length);
+
+    inline Iterator begin() const { return Iterator(this, 0); }
+    inline Iterator end() const { return Iterator(this, length); }
+    inline Value at(std::size_t index) const;
+
+    void push_back(const Value& value);
+    Value pop_back();
+    std::vector<Value>& detach();
+};
+
+// A window over shared character storage. Plain strings are slices covering
+// their whole buffer; `split` hands out slices into the source string, so
+// writers must call `detach` before touching the characters. Strings read
+// from files view the mapping directly instead of a buffer of their own.
+class StringSlice {
+public:
+    std::shared_ptr<std::string> storage;
+    std::shared_ptr<const MappedFile> mapping;
+    std::size_t offset;
+    std::size_t length;
+
+    // the buffer this slice created, windows and mappings hold none
+    Memory::Charge charge{Memory::Category::String};
+
+    StringSlice(const std::shared_ptr<std::string>& storage):
+        storage(storage), offset(0), length(storage->length()) { charge.resize(storage->capacity()); }
+    StringSlice(const std::shared_ptr<std::string>& storage, std::size_t offset, std::size_t length):
+        storage(storage), offset(offset), length(length) { }
+    StringSlice(const std::shared_ptr<const MappedFile>& mapping):
+        mapping(mapping), offset(0), length(mapping->size) { }
+
+    // a window into `source`, sharing whatever backs it
+    StringSlice(const StringSlice& source, std::size_t offset, std::size_t length):
+        storage(source.storage), mapping(source.mapping), offset(source.offset + offset), length(length) { }
+
+    inline std::string_view view() const {
+        return std::string_view((nullptr == mapping ? storage->data() : mapping->data) + offset, length);
+    }
+    std::string& detach();
+};
+
 class Value {
 public:
     Value(const long value): type(Type::Integer), value(value) { }
     Value(const double value): type(Type::Float), value(value) { }
     Value(const bool value): type(Type::Boolean), value(value) { }
-    Value(const std::shared_ptr<std::vector<Value>>& value): type(Type::Vector), value(value) { }
-    Value(const std::shared_ptr<std::string>& value): type(Type::String), value(value) { }
+    Value(const std::shared_ptr<std::vector<Value>>& value): type(Type::Vector), value(std::make_shared<VectorSlice>(value)) { Stats::count(Stats::Counter::VectorValues); }
+    Value(const std::shared_ptr<VectorSlice>& value): type(Type::Vector), value(value) { Stats::count(Stats::Counter::VectorValues); }
+    Value(const std::shared_ptr<std::string>& value): type(Type::String), value(std::make_shared<StringSlice>(value)) { Stats::count(Stats::Counter::StringValues); }
+    Value(const std::shared_ptr<StringSlice>& value): type(Type::String), value(value) { Stats::count(Stats::Counter::StringValues); }
+    Value(const std::shared_ptr<FunctionRef>& value): type(Type::Function), value(value) { Stats::count(Stats::Counter::FunctionValues); }
+    Value(const std::shared_ptr<Matrix>& value): type(Type::Matrix), value(value) { Stats::count(Stats::Counter::MatrixValues); }
+    Value(const std::shared_ptr<Mask>& value): type(Type::Mask), value(value) { Stats::count(Stats::Counter::MaskValues); }
+    Value(const std::shared_ptr<Task>& value): type(Type::Task), value(value) { Stats::count(Stats::Counter::TaskValues); }
+    Value(const std::shared_ptr<Generator>& value): type(Type::Generator), value(value) { Stats::count(Stats::Counter::GeneratorValues); }
+    Value(const std::shared_ptr<File>& value): type(Type::File), value(value) { Stats::count(Stats::Counter::FileValues); }
 
     Value(): type(Type::Void) { }
 
@@ -46,6 +174,44 @@ public:
     Variant value;
 };
 
+inline VectorSlice::VectorSlice(const std::shared_ptr<std::vector<Value>>& storage):
+    storage(storage), element(Type::Any), offset(0), length(storage->size()) { charge.resize(storage->capacity() * sizeof(Value)); }
+
+inline VectorSlice::VectorSlice(const std::shared_ptr<std::vector<Value>>& storage, std::size_t offset, std::size_t length):
+    storage(storage), element(Type::Any), offset(offset), length(length) { }
+
+inline VectorSlice::VectorSlice(const std::shared_ptr<const MappedFile>& mapping, const Type element):
+    mapping(mapping), element(element), offset(0), length(mapping->size / sizeof(std::int64_t)) { }
+
+inline VectorSlice::VectorSlice(const VectorSlice& source, std::size_t offset, std::size_t length):
+    storage(source.storage), mapping(source.mapping), element(source.element), offset(source.offset + offset), length(length) { }
+
+Value VectorSlice::Iterator::operator*() const {
+    return slice->at(index);
+}
+
+Value VectorSlice::at(std::size_t index) const {
+    if (index >= length) {
+        throw std::out_of_range("VectorSlice::at");
+    }
+
+    if (nullptr == mapping) {
+        return (*storage)[offset + index];
+    }
+
+    // native byte order, which is what `attach` documents: little-endian
+    const auto raw = mapping->data + (offset + index) * sizeof(std::int64_t);
+    if (element == Type::Integer) {
+        auto number = std::int64_t(0);
+        std::memcpy(&number, raw, sizeof(number));
+        return Value(static_cast<long>(number));
+    }
+
+    auto number = 0.0;
+    std::memcpy(&number, raw, sizeof(number));
+    return Value(number);
+}
+
 class Argument {
 public:
     Type type;
@@ -59,8 +225,11 @@ public:
     std::string identifier;
     std::vector<Argument> arguments;
 
-    Method(const std::string& identifier, const std::vector<Argument>& arguments):
-        identifier(identifier), arguments(arguments) { }
+    // a variadic method takes any number of extra values after `arguments`
+    bool variadic;
+
+    Method(const std::string& identifier, const std::vector<Argument>& arguments, const bool variadic = false):
+        identifier(identifier), arguments(arguments), variadic(variadic) { }
 
     virtual ~Method() {}
 };
@@ -69,16 +238,86 @@ class BuiltinMethod: public Method {
 public:
     std::function<Value(std::vector<Value>&)> callable;
 
-    BuiltinMethod(const std::string& identifier, const std::vector<Argument>& arguments, const std::function<Value(std::vector<Value>&)>& callable):
-        Method(identifier, arguments), callable(callable) { }
+    // nullptr unless calls are traced
+    const Trace::Name* traced;
+
+    BuiltinMethod(const std::string& identifier, const std::vector<Argument>& arguments, const std::function<Value(std::vector<Value>&)>& callable, const bool variadic = false):
+        Method(identifier, arguments, variadic), callable(callable), traced(Trace::declare(identifier, Trace::Kind::Builtin)) { }
 };
 
 class CustomMethod: public Method {
 public:
     ELang::Meta::Block* block;
 
-    CustomMethod(const std::string identifier, const std::vector<Argument> arguments, ELang::Meta::Block* block):
-        Method(identifier, arguments), block(block) { }
+    // the body contains `yield`: calls return a Generator instead of running it
+    bool generator;
+
+    // where calls are counted and sampled, nullptr unless profiling
+    Profile::Function* profile;
+
+    // nullptr unless calls are traced
+    const Trace::Name* traced;
+
+    CustomMethod(const std::string identifier, const std::vector<Argument> arguments, ELang::Meta::Block* block, const bool generator = false):
+        Method(identifier, arguments), block(block), generator(generator), profile(Profile::declare(identifier)), traced(Trace::declare(identifier, Trace::Kind::Custom)) { }
+};
+
+class Context;
+
+// A function name used as a value, e.g. the `f` in `map(f, v)`. Calls resolve
+// against the overload set visible where the name was evaluated.
+class FunctionRef {
+public:
+    std::string name;
+    std::vector<std::shared_ptr<Method>> methods;
+    std::weak_ptr<Context> context;
+
+    FunctionRef(const std::string& name, const std::vector<std::shared_ptr<Method>>& methods, const std::shared_ptr<Context>& context):
+        name(name), methods(methods), context(context) { }
+};
+
+// Result slot of `spawn(f, args...)`. The body runs exactly once, on whichever
+// thread claims it first: a pool worker, or `fetch` when nobody started it yet.
+class Task {
+public:
+    std::function<Value()> body;
+    Value result;
+    std::exception_ptr error;
+    std::atomic<bool> claimed;
+    std::atomic<bool> finished;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    Task(const std::function<Value()>& body): body(body), claimed(false), finished(false) { }
+
+    inline bool claim() { return !claimed.exchange(true); }
+    void execute();
+};
+
+// What a call to a function containing `yield` returns. The body runs as a
+// coroutine: `next` resumes it up to the following `yield`, so consumers such
+// as `for` pull one value at a time and nothing is materialized. Builtins
+// producing values natively (e.g. `readlines`) pass a `pull` function instead
+// and skip the coroutine.
+class Generator {
+public:
+    std::string name;
+
+    Generator(const std::string& name, const std::function<void()>& body):
+        name(name), coroutine(new Coroutine(body)) { }
+    Generator(const std::string& name, const std::function<bool(Value&)>& pull):
+        name(name), pull(pull) { }
+
+    // false once the body has returned
+    bool next(Value& value);
+
+    // called by the `yield` statement, from inside the body
+    static void yield(const Value& value);
+
+private:
+    std::unique_ptr<Coroutine> coroutine;
+    std::function<bool(Value&)> pull;
+    Value yielded;
 };
 
 class Context {
@@ -87,32 +326,81 @@ public:
     std::map<std::string, Value> variables;
     std::shared_ptr<Context> parent;
 
-    Context(): methods(), variables(), parent(nullptr) { }
-    Context(std::shared_ptr<Context> parent) : methods(), variables(), parent(parent) { }
+    // assignments never reach past an isolated frame: whatever lives above it
+    // may be read concurrently by other threads
+    bool isolated;
+
+    // a read-only copy of a script's top-level scope handed to tasks
+    bool frozen;
+
+    // bumped on every write, lets readers tell whether a copy is still current
+    std::size_t version;
+
+    // the frame and its variables
+    Memory::Charge charge{Memory::Category::Context};
+
+    Context(): methods(), variables(), parent(nullptr), isolated(false), frozen(false), version(0) {
+        Stats::count(Stats::Counter::Contexts);
+        charge.resize(sizeof(Context));
+    }
+    Context(std::shared_ptr<Context> parent) : methods(), variables(), parent(parent), isolated(false), frozen(false), version(0) {
+        Stats::count(Stats::Counter::Contexts);
+        charge.resize(sizeof(Context));
+    }
 
     void register_method(const std::shared_ptr<Method>& method);
     void assign_variable(const std::string& name, const Value& value, bool force_local = false);
-    inline Value read_variable(const std::string& name);
+    inline Value read_variable(const std::string& name) const;
+    bool find_variable(const std::string& name, Value& value) const;
     void locate_methods(std::vector<std::shared_ptr<ELang::Runtime::Method>>& results, const std::string& name) const;
 };
 
 class Interpreter {
 public:
     Interpreter();
-    ~Interpreter() { }
+    ~Interpreter();
 
     std::shared_ptr<Context> global_context;
 
     Value run(const ELang::Meta::Block* program, const std::shared_ptr<Context>& context);
     void register_builtins();
 
+    // until every spawned task has finished, fetched or not. Tasks write into
+    // the capture of the run that spawned them, so that run's host waits here
+    // before the capture goes away.
+    void wait_for_tasks();
+
 protected:
     Value eval_expression(const ELang::Meta::Expression& expression, const std::shared_ptr<Context>& context);
     Value call_function(const ELang::Meta::FunctionCall* expression, const std::shared_ptr<Context>& context);    
+    Value eval_operator(const int op, ELang::Meta::Expression& lhs, ELang::Meta::Expression& rhs,
+                        const ELang::Meta::Kernel kernel, const std::shared_ptr<Context>& context);
+    Value invoke(const std::string& name, const std::vector<std::shared_ptr<Method>>& methods, std::vector<Value>& values, const std::shared_ptr<Context>& context);
     inline void print_value(const Value& value) const;
+    void run_parallel_for(const ELang::Meta::ParallelForLoop* loop, const std::shared_ptr<Context>& context);
+
+    // higher order builtins, these need the interpreter to call back into E code
+    Value builtin_map(const std::vector<Value>& params);
+    Value builtin_filter(const std::vector<Value>& params);
+    Value builtin_reduce(const std::vector<Value>& params);
+    Value builtin_spawn(const std::vector<Value>& params);
+    Value builtin_fetch(const std::vector<Value>& params);
+    Value builtin_elapsed(const std::vector<Value>& params);
+    Value builtin_benchmark(const std::vector<Value>& params);
 
 private:
     inline Type get_type_from_identifier(const std::string& identifier) const;
+    std::shared_ptr<Context> isolated_frame(const FunctionRef& function);
+    std::shared_ptr<Context> task_scope(const FunctionRef& function);
+
+    // spawned bodies call back into this interpreter, so it outlives them
+    std::atomic<std::size_t> pending_tasks;
+
+    // what tasks see of the script's top-level scope, refreshed when it changes
+    std::shared_ptr<Context> task_snapshot;
+    std::weak_ptr<Context> task_snapshot_source;
+    std::size_t task_snapshot_version;
+    std::mutex snapshot_mutex;
 };
 
 } // namespace Runtime
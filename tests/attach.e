@@ -0,0 +1,20 @@
+# test vectors attached to raw binary files
+
+v = attach('attach.bin', 'Integer')
+show(length(v))
+show(v[3])
+
+total = 0
+parallel for x in v with sum(total)
+  total = total + x
+end
+show(total)
+
+w = v[2:3]
+push!(w, 99)
+show(length(w) * 100)
+show(w[3])
+
+# the push copied w out of the file, v still covers its four integers
+show(length(v) * 1000)
+show(v[3] * 10)
@@ -0,0 +1,17 @@
+# test save and load
+
+v = [1, 2, 3]
+data = [v, v, 'name', [0.5, 1.5], matrix([[1, 2], [3, 4]]), true, 42]
+save('checkpoint.bin', data)
+
+restored = load('checkpoint.bin')
+a = restored[1]
+b = restored[2]
+push!(a, 4)
+show(length(b))
+show(restored[3])
+floats = restored[4]
+show(floats[2])
+m = restored[5]
+show(m[2, 1])
+show(restored[7])
@@ -0,0 +1,43 @@
+# test file builtins
+
+out = open('files.txt', 'w')
+for i in range(5)
+    writeln(out, 'line ', i)
+end
+close(out)
+
+total = 0
+for line in readlines('files.txt')
+    total = total + length(line)
+end
+show(total)
+
+lines = collect(readlines(open('files.txt')))
+show(lines[5])
+
+text = read('files.txt')
+show(length(text))
+
+log = open('files.txt', 'a')
+write(log, 'tail ', 2.5)
+flush(log)
+appended = read('files.txt')
+show(appended[36:43])
+close(log)
+
+# rewriting a file leaves strings read from it as they were
+before = read('files.txt')
+rewrite = open('files.txt', 'w')
+write(rewrite, 'fresh')
+flush(rewrite)
+show(read('files.txt'))
+close(rewrite)
+show(before[1:6])
+close(open('files.txt', 'w'))
+show(length(read('files.txt')) == 0)
+
+# devices are written where they are
+null = open('/dev/null', 'w')
+writeln(null, 'discarded')
+close(null)
+show('null done')
@@ -0,0 +1,32 @@
+# test generators
+
+function numbers(n::Integer)
+  i = 0
+  while i < n
+    i = i + 1
+    yield i
+  end
+end
+
+function squares(src::Generator)
+  for x in src
+    yield x * x
+  end
+end
+
+function odd(src::Generator)
+  for x in src
+    if not (x == (x / 2) * 2)
+      yield x
+    end
+  end
+end
+
+total = 0
+for s in odd(squares(numbers(100000)))
+  total = total + s
+end
+
+show(total)
+show(collect(squares(numbers(4))))
+show(numbers(3))
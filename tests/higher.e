@@ -0,0 +1,17 @@
+# test map, filter and reduce
+
+function sqr(x::Integer)
+  x*x
+end
+
+function even(x::Integer)
+  x == (x / 2) * 2
+end
+
+function sum(a::Integer, b::Integer)
+  a + b
+end
+
+v = map(sqr, 1:1000)
+show(length(filter(even, v)))
+show(reduce(sum, v, 0))
@@ -0,0 +1,43 @@
+# operators specialized from parameter annotations
+function half(n::Integer)
+    n / 2
+end
+
+function average(a::Integer, b::Float)
+    total = a + b
+    total / 2
+end
+
+function ordered(a::Boolean, b::Boolean)
+    a < b
+end
+
+# callees can rebind a caller's variable, the specialized + falls back
+function widen()
+    x = 0.5
+end
+
+function grow(x::Integer)
+    widen()
+    x * 4
+end
+
+# overloads declared by the script are still found
+function __sub__(a::String, b::String)
+    a
+end
+
+function count(n::Integer)
+    i = 0
+    for k in 1:n
+        i = i + k
+    end
+    i
+end
+
+show(half(7))
+show(average(1, 2.0))
+show(ordered(false, true))
+show(grow(1))
+show('left' - 'right')
+show(count(10))
@@ -0,0 +1,16 @@
+# test packed boolean masks
+
+v = 1:1000
+m = v > 900
+small = v <= 10
+
+show(count(m))
+show(count(m or small))
+show(v[v > 997])
+
+# 1100 bits take eighteen words, the last one partly: the vector loops go
+# four words at a time, so the last two words run through their scalar tail
+u = 1:1100
+tail = u > 1060
+show(count(tail) * 1000)
+show([any(m and small), all(not (m and small)), all(u >= 1), all(u < 1100), any(u > 1099), any(u > 1100), all(tail or (u <= 1060))])
@@ -0,0 +1,9 @@
+# test matrix type
+
+a = matrix([[1, 2, 3], [4, 5, 6]])
+b = transpose(a)
+c = matmul(a, b)
+
+show(c)
+show(c[2, 1])
+show(rowsum(a))
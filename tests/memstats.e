@@ -0,0 +1,26 @@
+# memory accounting, run with --mem-report
+v = []
+for i in 1:1000
+    push!(v, i)
+end
+
+usage = memstats('Vector')
+show(usage[1] > 0)
+show(usage[2] >= usage[1])
+
+rows = memstats()
+show(length(rows))
+
+# vectors read back by load() are charged like any other; strings load as
+# views of the file, so only the vector's own storage counts
+names = []
+for i in 1:1000
+    push!(names, 'name')
+end
+save('memstats.bin', names)
+before = memstats('Vector')
+loaded = load('memstats.bin')
+after = memstats('Vector')
+if (after[1] - before[1]) >= (length(loaded) * 16)
+    show('loaded vector charged')
+end
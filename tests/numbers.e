@@ -0,0 +1,26 @@
+# test loading numbers from text files
+
+function sum(a::Integer, b::Integer)
+  a + b
+end
+
+out = open('numbers.csv', 'w')
+writeln(out, 'id, weight')
+for i in range(1000)
+    writeln(out, i, ', ', i * 0.5)
+end
+close(out)
+
+columns = readcsv('numbers.csv')
+ids = columns[1]
+weights = columns[2]
+show(length(ids))
+show(reduce(sum, ids, 0))
+show(weights[1000])
+
+out = open('numbers.csv', 'w')
+writeln(out, '1 2 3')
+writeln(out, '4.5  -6')
+close(out)
+
+show(readnumbers('numbers.csv'))
@@ -0,0 +1,31 @@
+# test parallel for loops with reductions
+
+a = 0
+lo = 1000
+hi = 0
+v = [0]
+w = v
+box = [v]
+
+parallel for i in 1:1000 with sum(a), min(lo), max(hi), push(v)
+  sq = i * i
+  a = a + sq
+  if sq < lo
+    lo = sq
+  end
+  if sq > hi
+    hi = sq
+  end
+  if sq < 50
+    push!(v, sq)
+  end
+end
+
+show(a)
+show(lo)
+show(hi)
+show(v)
+
+# aliases of the vector see the pushed elements too
+show(length(w) * 100)
+show(length(box[1]) * 1000)
@@ -0,0 +1,13 @@
+# test print, println and flush
+print('answer: ', 42)
+println()
+println(1.5, ' ', 2.0, ' ', 0 - 3)
+println([1, 2.5, 'three', true])
+println(matrix([[1, 2], [3, 4]]))
+println(mask([true, false, true]))
+buffering('full')
+for i in range(3)
+    print(i, ',')
+end
+flush()
+println()
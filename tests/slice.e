@@ -0,0 +1,12 @@
+# test range indexing
+
+v = [1, 2, 3, 4, 5, 6]
+w = v[2:4]
+push!(w, 10)
+pop!(v)
+
+show(w)
+show(length(v))
+
+s = 'the book is on the table'
+show(s[5:8])
@@ -0,0 +1,11 @@
+# test string search and replace builtins
+
+line = 'GET /index.html 200 GET /about.html 404'
+
+show(find(line, 'GET'))
+show(find(line, 'GET', 2))
+show(contains(line, '404'))
+show(startswith(line, 'POST'))
+show(replace(line, 'GET', 'HEAD'))
+show(upper('mixed Case 42'))
+show(split(line, ' GET '))
@@ -0,0 +1,34 @@
+# test spawn and fetch
+
+function fib(n::Integer)
+  if n < 2
+    n
+  else
+    fib(n-1) + fib(n-2)
+  end
+end
+
+# arguments are always local, unlike assignments in a recursive body
+function join(t::Task, b::Integer)
+  fetch(t) + b
+end
+
+function pfib(n::Integer)
+  if n < 12
+    fib(n)
+  else
+    join(spawn(pfib, n-1), pfib(n-2))
+  end
+end
+
+function scaled(x::Integer, k::Integer)
+  factor = factor * k
+  x * factor
+end
+
+factor = 3
+t = spawn(scaled, 5, 2)
+factor = 100
+show(fetch(t))
+show(factor)
+show(pfib(20))
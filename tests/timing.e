@@ -0,0 +1,18 @@
+# clock access and micro-benchmarks
+function fib(n::Integer)
+    if n < 2
+        n
+    else
+        fib(n - 1) + fib(n - 2)
+    end
+end
+
+start = time_ns()
+t = elapsed(fib, 15)
+show(t > 0)
+show((time_ns() - start) >= t)
+
+stats = benchmark(fib, 10, 50)
+show(length(stats))
+show(stats[1] <= stats[2])
+show(stats[2] <= stats[3])
@@ -2,7 +2,7 @@
 
 . osht.sh
 
-PLAN 11
+PLAN 102
 
 run_script() {
     local SCRIPT=$1
@@ -42,4 +42,189 @@ IS "$OUTPUT" == *"55 (type: Integer)"
 
 # string.e
 run_script "string.e"
-IS "$OUTPUT" == *"'the book is on the table' (type: String)"
\ No newline at end of file
+IS "$OUTPUT" == *"'the book is on the table' (type: String)"
+
+# stringops.e
+run_script "stringops.e"
+IS "$OUTPUT" == *"21 (type: Integer)"*
+IS "$OUTPUT" == *"true (type: Boolean)"*
+IS "$OUTPUT" == *"'HEAD /index.html 200 HEAD /about.html 404' (type: String)"*
+IS "$OUTPUT" == *"'MIXED CASE 42' (type: String)"*
+IS "$OUTPUT" == *"1: '/about.html 404' (type: String)"*
+
+# slice.e
+run_script "slice.e"
+IS "$OUTPUT" == *"Vector with 4 elements"*
+IS "$OUTPUT" == *"5 (type: Integer)"*
+IS "$OUTPUT" == *"'book' (type: String)"*
+
+# a slice may start just past the end, and be empty, but no further
+OUTPUT=$(printf "v = [1, 2, 3]\nshow(length(v[4:3]))\nshow(v[100:1])\n" | ../out/debug/elc 2>&1)
+IS "$OUTPUT" == *"0 (type: Integer)"*
+IS "$OUTPUT" == *"Out of bounds."*
+
+# a literal past the range of its type is a syntax error, not a wrapped value
+OUTPUT=$(printf "show(9223372036854775807)\nshow(9223372036854775808)\n" | ../out/debug/elc 2>&1)
+IS "$OUTPUT" == *"ERROR: line 2: integer literal out of range"*
+ISNT "$OUTPUT" == *"type: Integer"*
+
+# higher.e
+run_script "higher.e"
+IS "$OUTPUT" == *"500 (type: Integer)"*
+IS "$OUTPUT" == *"333833500 (type: Integer)"*
+
+# matrix.e
+run_script "matrix.e"
+IS "$OUTPUT" == *"Matrix with 2x2 elements"*
+IS "$OUTPUT" == *"32 (type: Float)"*
+IS "$OUTPUT" == *"1: 15 (type: Float)"*
+
+# mask.e
+run_script "mask.e"
+IS "$OUTPUT" == *$'\n'"100 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *$'\n'"110 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *"2: 1000 (type: Integer)"*
+IS "$OUTPUT" == *$'\n'"40000 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *"0: false (type: Boolean)"*
+IS "$OUTPUT" == *"1: true (type: Boolean)"*
+IS "$OUTPUT" == *"2: true (type: Boolean)"*
+IS "$OUTPUT" == *"3: false (type: Boolean)"*
+IS "$OUTPUT" == *"4: true (type: Boolean)"*
+IS "$OUTPUT" == *"5: false (type: Boolean)"*
+IS "$OUTPUT" == *"6: true (type: Boolean)"*
+# tasks.e
+run_script "tasks.e"
+IS "$OUTPUT" == *"30 (type: Integer)"*
+IS "$OUTPUT" == *"100 (type: Integer)"*
+IS "$OUTPUT" == *"6765 (type: Integer)"*
+
+# parallel.e
+run_script "parallel.e"
+IS "$OUTPUT" == *"333833500 (type: Integer)"*
+IS "$OUTPUT" == *"1000000 (type: Integer)"*
+IS "$OUTPUT" == *"7: 49 (type: Integer)"*
+IS "$OUTPUT" == *$'\n'"1 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *"800 (type: Integer)"*
+IS "$OUTPUT" == *"8000 (type: Integer)"*
+
+# generator.e
+run_script "generator.e"
+IS "$OUTPUT" == *"166666666650000 (type: Integer)"*
+IS "$OUTPUT" == *"3: 16 (type: Integer)"*
+IS "$OUTPUT" == *"numbers (type: Generator)"*
+
+# print.e
+run_script "print.e"
+IS "$OUTPUT" == *"1.5 2.0 -3"*
+IS "$OUTPUT" == *"[1, 2.5, 'three', true]"*
+IS "$OUTPUT" == *"1,2,3,"*
+
+# files.e
+run_script "files.e"
+rm -f files.txt
+IS "$OUTPUT" == *"30 (type: Integer)"*
+IS "$OUTPUT" == *"'line 5' (type: String)"*
+IS "$OUTPUT" == *"'tail 2.5' (type: String)"*
+IS "$OUTPUT" == *"'fresh' (type: String)"*
+IS "$OUTPUT" == *"'line 1' (type: String)"*
+IS "$OUTPUT" == *"true (type: Boolean)"*
+IS "$OUTPUT" == *"'null done' (type: String)"*
+
+# a FIFO is written into, not replaced by a regular file
+rm -f files.fifo
+mkfifo files.fifo
+cat files.fifo > fifo.txt &
+echo "f = open('files.fifo', 'w') writeln(f, 'through') close(f)" | ../out/debug/elc > /dev/null
+wait
+IS "$(cat fifo.txt)" == "through"
+OK -p files.fifo
+rm -f files.fifo fifo.txt
+
+# a script failing halfway keeps what it wrote and leaves no staging files
+echo "old" > failing.txt
+echo "f = open('failing.txt', 'w') writeln(f, 'partial') nosuchfunction()" | ../out/debug/elc > /dev/null 2>&1
+IS "$(cat failing.txt)" == "partial"
+IS "$(ls failing.txt.~* 2> /dev/null)" == ""
+rm -f failing.txt
+
+# numbers.e
+run_script "numbers.e"
+rm -f numbers.csv
+IS "$OUTPUT" == *"500500 (type: Integer)"*
+IS "$OUTPUT" == *"500 (type: Float)"*
+IS "$OUTPUT" == *"3: 4.5 (type: Float)"*
+
+# a first line with some fields that don't parse is a bad row, not a header
+printf '1,,2\n3,4,5\n' > header.csv
+OUTPUT=$(echo "readcsv('header.csv')" | ../out/debug/elc 2>&1)
+rm -f header.csv
+IS "$OUTPUT" == *"header.csv:1:"*
+
+# checkpoint.e
+run_script "checkpoint.e"
+rm -f checkpoint.bin
+IS "$OUTPUT" == *"4 (type: Integer)"*
+IS "$OUTPUT" == *"'name' (type: String)"*
+IS "$OUTPUT" == *"3 (type: Float)"*
+
+# attach.e, over the little-endian 64-bit integers 11 22 33 44
+for n in 11 22 33 44; do printf "\\$(printf '%03o' $n)\\0\\0\\0\\0\\0\\0\\0"; done > attach.bin
+run_script "attach.e"
+rm -f attach.bin
+IS "$OUTPUT" == *$'\n'"4 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *$'\n'"33 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *$'\n'"110 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *$'\n'"300 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *$'\n'"99 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *$'\n'"4000 (type: Integer)"$'\n'*
+IS "$OUTPUT" == *$'\n'"330 (type: Integer)"
+
+# timing.e
+run_script "timing.e"
+IS "$OUTPUT" == *"3 (type: Integer)"*
+ISNT "$OUTPUT" == *"false"*
+
+# infer.e
+run_script "infer.e"
+IS "$OUTPUT" == *"3 (type: Integer)"*
+IS "$OUTPUT" == *"1.5 (type: Float)"*
+IS "$OUTPUT" == *"true (type: Boolean)"*
+IS "$OUTPUT" == *"2 (type: Float)"*
+IS "$OUTPUT" == *"'left' (type: String)"*
+IS "$OUTPUT" == *"55 (type: Integer)"*
+
+# --serve never deletes a file that isn't a socket
+echo "1,2,3" > results.csv
+../out/debug/elc --serve ./results.csv > /dev/null 2>&1
+ISNT $? -eq 0
+IS "$(cat results.csv)" == "1,2,3"
+rm -f results.csv
+
+# scripts can also be given as a path
+OUTPUT=$(../out/debug/elc ./fibonacci.e)
+IS "$OUTPUT" == *"55 (type: Integer)"*
+
+# --profile reports on stderr and leaves collapsed stacks beside the script
+OUTPUT=$(../out/debug/elc --profile ./fibonacci.e 2>&1)
+IS "$OUTPUT" == *"calls  function"*
+OK -f ./fibonacci.e.folded
+rm -f ./fibonacci.e.folded
+
+# --stats counts evaluated nodes and dispatches
+OUTPUT=$(../out/debug/elc --stats ./fibonacci.e 2>&1)
+IS "$OUTPUT" == *"FunctionCall"*
+IS "$OUTPUT" == *"custom"*
+
+# --mem-report tracks live and peak bytes, memstats() reads them in a script
+OUTPUT=$(../out/debug/elc --mem-report ./memstats.e 2>&1)
+IS "$OUTPUT" == *"true (type: Boolean)"*
+IS "$OUTPUT" == *"5 (type: Integer)"*
+IS "$OUTPUT" == *"memstats.e:4"*
+IS "$OUTPUT" == *"'loaded vector charged' (type: String)"*
+rm -f ./memstats.bin
+
+# --trace writes Chrome trace events, one per call
+OUTPUT=$(../out/debug/elc --trace ./trace.json ./fibonacci.e 2>&1)
+IS "$OUTPUT" == *"Trace written to ./trace.json"*
+IS "$(cat ./trace.json)" == *'"name":"fib","cat":"function","ph":"X"'*
+rm -f ./trace.json